@@ -0,0 +1,233 @@
+// Smart Serow - Bench
+// On-target micro-benchmarks for the main sketch's hot paths
+// Flash to a bare Nano, open the serial monitor at 115200, read the table.
+//
+// Cycles are counted on Timer1 at prescaler 1 (16MHz, 62.5ns per count) with
+// interrupts off; the empty-measurement overhead is subtracted. Each row is the
+// fastest of RUNS passes over varying inputs - max 65535 cycles (4ms) per call.
+// Timer1 belongs to AltSoftSerial in the main sketch, so this is bench-only.
+//
+// Sections: IMU parsing, voltage, TSV field formatting, frames, fusion, then a
+// telemetry budget - whole-frame cost as CPU share of a 10Hz and a 50Hz stream.
+// Rows that re-enable interrupts inside (voltage reads) can catch an ISR; the
+// best-of-RUNS pass filters that out.
+
+#include "../main/comms.h"
+#include "../main/fusion.h"
+#include "../main/voltage.h"
+
+// imu.cpp built into this file, not a *_src.cpp: processPacket() and rxBuf are
+// file statics. imu_init() never runs, so AltSoftSerial leaves Timer1 alone.
+#include "../main/imu.cpp"
+
+#if !defined(__AVR_ATmega328P__)
+#error "bench counts cycles on the ATmega328P's Timer1 (Arduino Nano)"
+#endif
+
+static const uint8_t RUNS = 16;
+static const uint32_t CYCLES_PER_SECOND = F_CPU;
+
+static uint16_t overhead = 0;
+static volatile int16_t sink;  // Keeps results alive past the optimiser
+
+// Varying inputs: a slowly tumbling 1g vector plus a bit of gyro
+static int16_t sampleAcc[3];
+static int16_t sampleGyro[3];
+
+static void makeSample(uint8_t i) {
+  sampleAcc[0] = (int16_t)(i * 37) - 300;
+  sampleAcc[1] = 700 - (int16_t)(i * 53);
+  sampleAcc[2] = 1900 + i;
+  sampleGyro[0] = (int16_t)(i * 11) - 80;
+  sampleGyro[1] = 40 - i;
+  sampleGyro[2] = i;
+}
+
+// prep(i) runs untimed before each pass, for state the call consumes
+template <typename Prep, typename Fn>
+static uint16_t measure(Prep prep, Fn fn) {
+  uint16_t best = 0xFFFF;
+  for (uint8_t i = 0; i < RUNS; i++) {
+    makeSample(i);
+    prep(i);
+    noInterrupts();
+    TCNT1 = 0;
+    fn();
+    uint16_t t = TCNT1;
+    interrupts();
+    if (t < best) best = t;
+  }
+  return best > overhead ? best - overhead : 0;
+}
+
+template <typename Fn>
+static uint16_t measure(Fn fn) {
+  return measure([](uint8_t) {}, fn);
+}
+
+static void printRow(const __FlashStringHelper* name, uint16_t cycles, uint16_t perSecond) {
+  // name | cycles | us | % CPU at perSecond calls/s
+  Serial.print(name);
+  Serial.print(F("\t"));
+  Serial.print(cycles);
+  Serial.print(F("\t"));
+  Serial.print(cycles / (CYCLES_PER_SECOND / 1000000.0), 1);
+  Serial.print(F("\t"));
+  Serial.print(100.0 * cycles * perSecond / CYCLES_PER_SECOND, 2);
+  Serial.println(F("%"));
+}
+
+// '/dev/null' Print: formatting cost alone, without the UART
+class NullPrint : public Print {
+ public:
+  size_t write(uint8_t) override { return 1; }
+};
+static NullPrint nullOut;
+
+static volatile int16_t rawIn;  // Keeps the optimiser from folding constant inputs
+
+// One WT61 packet into the parser's buffer, checksum filled in
+static void loadPacket(uint8_t type, uint8_t i) {
+  rxBuf[0] = PACKET_HEADER;
+  rxBuf[1] = type;
+  for (uint8_t k = 2; k < PACKET_SIZE - 1; k++) rxBuf[k] = (uint8_t)(k * 29 + i);
+  uint8_t sum = 0;
+  for (uint8_t k = 0; k < PACKET_SIZE - 1; k++) sum += rxBuf[k];
+  rxBuf[PACKET_SIZE - 1] = sum;
+}
+
+static ImuRaw copyOut;
+
+static void benchImu() {
+  // Three packets per burst: accel/gyro rows run IMU_RATE_HZ times a second too
+  printRow(F("validateChecksum"), measure([](uint8_t i) { loadPacket(PACKET_ACCEL, i); },
+                                          [] { sink = validateChecksum(); }), IMU_RATE_HZ * 3);
+  printRow(F("processPacket accel"), measure([](uint8_t i) { loadPacket(PACKET_ACCEL, i); },
+                                             [] { sink = processPacket(); }), IMU_RATE_HZ);
+  printRow(F("processPacket angle"), measure([](uint8_t i) { loadPacket(PACKET_ANGLE, i); },
+                                             [] { sink = processPacket(); }), IMU_RATE_HZ);
+  printRow(F("imu_get_data copy"), measure([] { copyOut = imu_get_data(); }), IMU_RATE_HZ);
+}
+
+static void benchVoltage() {
+  printRow(F("voltage_read_mv"), measure([] { sink = voltage_read_mv(); }), 10);
+  printRow(F("voltage_read"), measure([] { sink = (int16_t)(voltage_read() * 100); }), 10);
+}
+
+// Print's own formatting, one row per TSV field kind (TSV has 1 vbat, 3 each
+// of accel/gyro/angle, then rpm, gear as integers, speed, then seq, t_ms) -
+// what comms.cpp's integer encoder replaces, compare "tsv frame (ALL)" below
+static const uint8_t WRITE_BYTES = 8;
+static uint8_t writeBuf[WRITE_BYTES];
+
+static void benchTsv() {
+  auto vary = [](uint8_t i) { rawIn = (int16_t)(i * 997) - 8000; };
+  printRow(F("print vbat (float,2)"), measure([](uint8_t i) { rawIn = 12000 + i * 173; },
+                                              [] { nullOut.print(rawIn * 0.001, 2); }), 50);
+  printRow(F("print accel (float,2)"), measure(vary, [] { nullOut.print(rawIn * IMU_ACCEL_SCALE, 2); }), 50);
+  printRow(F("print gyro (float,2)"), measure(vary, [] { nullOut.print(rawIn * IMU_GYRO_SCALE, 2); }), 50);
+  printRow(F("print angle (float,2)"), measure(vary, [] { nullOut.print(rawIn * IMU_ANGLE_SCALE, 2); }), 50);
+  printRow(F("print rpm (int)"), measure([](uint8_t i) { rawIn = 1000 + i * 457; },
+                                         [] { nullOut.print(rawIn); }), 50);
+  printRow(F("print speed (float,1)"), measure([](uint8_t i) { rawIn = 300 + i * 29; },
+                                               [] { nullOut.print(rawIn * 0.1, 1); }), 50);
+  printRow(F("print t_ms (ulong)"), measure([](uint8_t i) { rawIn = i; },
+                                            [] { nullOut.print(3600000UL + rawIn); }), 50);
+
+  // Into an empty TX buffer - the cost of the bytes themselves, not the wait
+  // for room. The first goes straight to UDR0, the rest queue for the UDRE ISR.
+  printRow(F("Serial.write 8 bytes"), measure([](uint8_t) { Serial.flush(); },
+                                              [] { Serial.write(writeBuf, WRITE_BYTES); }),
+           50 * 76 / WRITE_BYTES);
+}
+
+static uint16_t tsvFrame, binaryFrame;
+static ImuRaw frameImu;
+
+// Whole frames, into the TX queue (comms.cpp) - handing the first bytes to
+// Serial is included, waiting on the wire is not: prep empties the queue
+static void fillFrame(uint8_t i) {
+  while (comms_tx_pending() > 0) comms_update();
+  Serial.flush();
+  frameImu.ax = sampleAcc[0]; frameImu.ay = sampleAcc[1]; frameImu.az = sampleAcc[2];
+  frameImu.gx = sampleGyro[0]; frameImu.gy = sampleGyro[1]; frameImu.gz = sampleGyro[2];
+  frameImu.roll = i * 300; frameImu.pitch = -i * 50; frameImu.yaw = i * 1000;
+}
+
+static void benchFrames() {
+  comms_set_format(FORMAT_TSV);
+  tsvFrame = measure(fillFrame, [] { comms_send_telemetry(13800, frameImu, 4200, 3, 652, TLM_ALL); });
+  printRow(F("tsv frame (ALL)"), tsvFrame, 50);
+  comms_set_format(FORMAT_BINARY);
+  binaryFrame = measure(fillFrame, [] { comms_send_telemetry(13800, frameImu, 4200, 3, 652, TLM_ALL); });
+  printRow(F("binary frame (ALL)"), binaryFrame, 50);
+
+  // CMD:AGG: per-sample fold, then a frame with its statistics + range frame
+  comms_set_stat(STAT_PEAK);
+  comms_set_range(true);
+  printRow(F("comms_aggregate_imu"), measure(fillFrame, [] { comms_aggregate_imu(frameImu); }),
+           IMU_RATE_HZ);
+  printRow(F("binary frame (PEAK+range)"),
+           measure([](uint8_t i) { fillFrame(i); comms_aggregate_imu(frameImu); },
+                   [] { comms_send_telemetry(13800, frameImu, 4200, 3, 652, TLM_ALL); }), 50);
+  comms_set_stat(STAT_LAST);
+  comms_set_range(false);
+  comms_set_format(FORMAT_TSV);
+  fillFrame(0);
+}
+
+// name | cycles | us | % CPU at 10Hz | % CPU at 50Hz
+static void printBudget(const __FlashStringHelper* name, uint32_t cycles) {
+  Serial.print(name);
+  Serial.print(F("\t"));
+  Serial.print(cycles);
+  Serial.print(F("\t"));
+  Serial.print(cycles / (CYCLES_PER_SECOND / 1000000.0), 1);
+  Serial.print(F("\t"));
+  Serial.print(100.0 * cycles * 10 / CYCLES_PER_SECOND, 2);
+  Serial.print(F("%\t"));
+  Serial.print(100.0 * cycles * 50 / CYCLES_PER_SECOND, 2);
+  Serial.println(F("%"));
+}
+
+static void benchBudget() {
+  printBudget(F("tsv frame"), tsvFrame);
+  printBudget(F("binary frame"), binaryFrame);
+}
+
+static void benchFusion() {
+  printRow(F("fusion_isqrt"), measure([] {
+    sink = fusion_isqrt((uint32_t)sampleAcc[1] * sampleAcc[1] + (uint32_t)sampleAcc[2] * sampleAcc[2]);
+  }), 200);
+  printRow(F("fusion_atan2"), measure([] { sink = fusion_atan2(sampleAcc[1], sampleAcc[2]); }), 200);
+  printRow(F("fusion_mount"), measure([] { fusion_mount(sampleAcc); sink = sampleAcc[0]; }), 200);
+  printRow(F("fusion_update"), measure([] { fusion_update(sampleAcc, sampleGyro); sink = fusion_roll(); }), 100);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // Timer1 free-running at the CPU clock
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  overhead = 0;
+  overhead = measure([] {});
+
+  fusion_set_mount(-300, 700, 1900);
+  fusion_update(sampleAcc, sampleGyro);  // Seed, so update rows time the full path
+  voltage_init();                        // ADC_vect keeps the window filled
+
+  Serial.println(F("# Smart Serow bench - cycles @ 16MHz, best of 16"));
+  Serial.println(F("# name\tcycles\tus\tcpu (at calls/s)"));
+  benchImu();
+  benchVoltage();
+  benchTsv();
+  benchFrames();
+  benchFusion();
+  Serial.println(F("# telemetry budget - name\tcycles\tus\tcpu at 10Hz\tcpu at 50Hz"));
+  benchBudget();
+  Serial.println(F("# done"));
+}
+
+void loop() {
+}
@@ -0,0 +1,2 @@
+// Build the main sketch's module into this one (the IDE only compiles files in the sketch folder)
+#include "../main/fusion.cpp"
@@ -0,0 +1,130 @@
+// Host benchmarks for the firmware hot paths
+// Absolute times are the host's, not the AVR's (see arduino/bench/ for real
+// cycle counts) - use them to compare variants and catch regressions.
+// Byte counts and parser recovery rates carry over to the target as-is.
+
+#include <chrono>
+#include "shim.h"
+#include "wt61_gen.h"
+#include "comms.h"
+#include "fusion.h"
+#include "imu.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsSince(Clock::time_point start, unsigned long n) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+static volatile int16_t sink;
+
+// Frames of a bike weaving about, so delta frames see realistic movement
+static void makeFrame(unsigned long i, ImuRaw& d, int& mv, int& rpm) {
+  double t = i / 20.0;
+  d.ax = (int16_t)(60 * sin(t * 3));
+  d.ay = (int16_t)(1000 * sin(t * 0.8));
+  d.az = (int16_t)(1800 + 40 * sin(t * 5));
+  d.gx = (int16_t)(400 * cos(t * 0.8));
+  d.gy = (int16_t)(30 * sin(t * 7));
+  d.gz = (int16_t)(90 * sin(t * 0.3));
+  d.roll = (int16_t)(5461 * sin(t * 0.8));
+  d.pitch = (int16_t)(180 * sin(t * 2));
+  d.yaw = (int16_t)(i * 37);
+  d.lastUpdate = i * 50;
+  d.lastUpdateUs = i * 50000;
+  mv = 13800 + (int)(40 * sin(t));
+  rpm = 4000 + (int)(2500 * sin(t * 0.2));
+}
+
+static void benchEncode(const char* name, TelemetryFormat format, bool delta) {
+  const unsigned long N = 200000;
+  comms_set_format(format);
+  comms_set_delta(delta);
+  shim_serial_capture(nullptr);
+  Serial.txRoom = 0x7FFF;  // Link never the bottleneck: each frame drains on commit
+
+  ImuRaw d = {};
+  int mv, rpm;
+  unsigned long bytes0 = shim_serial_bytes();
+  Clock::time_point start = Clock::now();
+  for (unsigned long i = 0; i < N; i++) {
+    makeFrame(i, d, mv, rpm);
+    shim_set_us(d.lastUpdateUs);
+    comms_send_telemetry(mv, d, rpm, 3, 652, TLM_ALL);
+  }
+  double ns = nsSince(start, N);
+  double bytes = (double)(shim_serial_bytes() - bytes0) / N;
+  printf("%-18s %8.0f ns/frame %7.1f bytes/frame %7.0f B/s at 20Hz\n", name, ns, bytes, bytes * 20);
+}
+
+static void benchParser(double corrupt) {
+  const size_t BURSTS = 20000;
+  std::vector<uint8_t> clean = wt61_stream(BURSTS);
+  std::vector<uint8_t> data = clean;
+  if (corrupt > 0) wt61_corrupt(data, corrupt, 7);
+  size_t intact = corrupt > 0 ? wt61_intact_angles(clean, data) : BURSTS;
+
+  imu_init();
+  shim_imu_feed(data.data(), data.size());
+
+  // ImuStats wrap at 65535 - total up the per-poll deltas instead
+  ImuStats prev = imu_get_stats();
+  unsigned long samples = 0, bad = 0, resyncs = 0, skipped = 0;
+  double ns = 0;
+  while (shim_imu_pending() > 0) {
+    // One packet's worth per poll, so at most one sample completes per call
+    shim_imu_release(11);
+    Clock::time_point start = Clock::now();
+    bool got = imu_update();
+    ns += nsSince(start, 1);
+    if (got) samples++;
+
+    ImuStats s = imu_get_stats();
+    bad += (uint16_t)(s.checksumErrors - prev.checksumErrors);
+    resyncs += (uint16_t)(s.resyncs - prev.resyncs);
+    skipped += (uint16_t)(s.droppedBytes - prev.droppedBytes);
+    prev = s;
+  }
+
+  // Samples can exceed intact: the 8-bit checksum passes some corrupted packets
+  printf("parser p=%-6.3f %6.1f ns/byte  samples %5lu/%-5zu intact  bad %5lu  resync %5lu  skipped %6lu\n",
+         corrupt, ns / data.size(), samples, intact, bad, resyncs, skipped);
+}
+
+static void benchFusion() {
+  const unsigned long N = 1000000;
+  int16_t acc[3], gyro[3];
+  fusion_reset();
+  Clock::time_point start = Clock::now();
+  for (unsigned long i = 0; i < N; i++) {
+    acc[0] = (int16_t)(i & 255) - 128;
+    acc[1] = (int16_t)((i * 7) & 1023) - 512;
+    acc[2] = 1900;
+    gyro[0] = (int16_t)(i & 63) - 32;
+    gyro[1] = 5;
+    gyro[2] = 0;
+    fusion_mount(acc);
+    fusion_update(acc, gyro);
+    sink = fusion_roll();
+  }
+  printf("fusion mount+update %8.1f ns/sample\n", nsSince(start, N));
+}
+
+int main() {
+  printf("# encode (TLM_ALL every frame)\n");
+  benchEncode("tsv", FORMAT_TSV, false);
+  benchEncode("tsv delta", FORMAT_TSV, true);
+  benchEncode("binary", FORMAT_BINARY, false);
+  benchEncode("binary delta", FORMAT_BINARY, true);
+  benchEncode("batch", FORMAT_BATCH, false);
+
+  printf("# WT61 parser (20k bursts, byte flips with probability p)\n");
+  benchParser(0);
+  benchParser(0.001);
+  benchParser(0.01);
+  benchParser(0.05);
+
+  printf("# fusion\n");
+  benchFusion();
+  return 0;
+}
@@ -0,0 +1,21 @@
+// Host shim: AltSoftSerial reading from a harness-fed byte buffer (TX dropped)
+#ifndef ALTSOFTSERIAL_SHIM_H
+#define ALTSOFTSERIAL_SHIM_H
+
+#include <Arduino.h>
+
+class AltSoftSerial : public Stream {
+ public:
+  AltSoftSerial();
+  void begin(unsigned long baud) { this->baud = baud; }
+  void end() {}
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  int available() override { return rx->available(); }
+  int read() override { return rx->read(); }
+
+  unsigned long baud = 0;
+  ShimRx* rx;
+};
+
+#endif
@@ -0,0 +1,178 @@
+// Host shim for the Arduino core - just enough for the arduino/main modules
+// Not a full core: AVR-only register code stays behind its #if guards and is
+// never compiled here. Time is virtual (see shim.h), Serial output goes to a
+// pluggable sink so frames can be captured, counted or dropped.
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// Flash strings are plain RAM strings on the host
+#define PROGMEM
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PSTR(s) (s)
+typedef const char* PGM_P;
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+// Nano pin numbers
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A6 20
+#define A7 21
+#define LED_BUILTIN 13
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+#define F_CPU 16000000UL
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+#define noInterrupts()
+#define interrupts()
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+int analogRead(uint8_t pin);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void pinMode(uint8_t pin, uint8_t mode);
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t irq);
+
+// Print with the core's formatting - printFloat mirrors the AVR one (double is
+// float there), so TSV output is byte-identical to the target's
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    size_t r = 0;
+    while (n--) r += write(*buf++);
+    return r;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* buf, size_t n) { return write((const uint8_t*)buf, n); }
+  virtual int availableForWrite() { return 0; }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const __FlashStringHelper* s) { return write((const char*)s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return printNumber(n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return printNumber(n, base); }
+  size_t print(long n, int base = DEC) {
+    if (n < 0 && base == DEC) return print('-') + printNumber(-(unsigned long)n, base);
+    return printNumber(n, base);
+  }
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+  size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  template <typename T> size_t println(T v, int fmt) { return print(v, fmt) + println(); }
+
+ private:
+  size_t printNumber(unsigned long n, uint8_t base) {
+    char buf[8 * sizeof(long) + 1];
+    char* str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    do {
+      char c = n % base;
+      n /= base;
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+  }
+
+  size_t printFloat(double number, uint8_t digits) {
+    float num = (float)number;
+    size_t n = 0;
+    if (isnan(num)) return print("nan");
+    if (isinf(num)) return print("inf");
+    if (num > 4294967040.0f || num < -4294967040.0f) return print("ovf");
+    if (num < 0.0f) {
+      n += print('-');
+      num = -num;
+    }
+    float rounding = 0.5f;
+    for (uint8_t i = 0; i < digits; ++i) rounding /= 10.0f;
+    num += rounding;
+    unsigned long intPart = (unsigned long)num;
+    float remainder = num - (float)intPart;
+    n += print(intPart);
+    if (digits > 0) n += print('.');
+    while (digits-- > 0) {
+      remainder *= 10.0f;
+      unsigned int toPrint = (unsigned int)remainder;
+      n += print(toPrint);
+      remainder -= toPrint;
+    }
+    return n;
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  virtual void flush() {}
+};
+
+// Byte queue fed by the harness (RX side of Serial / AltSoftSerial)
+struct ShimRx {
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  size_t pos = 0;
+  size_t limit = 0;  // Bytes "arrived" so far - the harness releases them over time
+  int available() const { return (int)(limit - pos); }
+  int read() { return pos < limit ? data[pos++] : -1; }
+};
+
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(ShimRx* rx) : rx(rx) {}
+  void begin(unsigned long baud) { this->baud = baud; }
+  void end() {}
+  size_t write(uint8_t b) override;
+  using Print::write;
+  int availableForWrite() override { return txRoom; }
+  int available() override { return rx->available(); }
+  int read() override { return rx->read(); }
+  operator bool() { return true; }
+
+  unsigned long baud = 0;
+  int txRoom = 63;  // What availableForWrite() reports
+  ShimRx* rx;       // Serial: shim_serial_feed(), Serial1: the IMU feed
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif
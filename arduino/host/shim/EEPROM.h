@@ -0,0 +1,26 @@
+// Host shim: 1KB EEPROM in RAM, erased (0xFF) at start
+#ifndef EEPROM_SHIM_H
+#define EEPROM_SHIM_H
+
+#include <Arduino.h>
+
+struct EEPROMClass {
+  uint8_t mem[1024];
+  EEPROMClass() { memset(mem, 0xFF, sizeof(mem)); }
+  uint8_t read(int addr) { return mem[addr]; }
+  void write(int addr, uint8_t v) { mem[addr] = v; }
+  void update(int addr, uint8_t v) { mem[addr] = v; }
+  template <typename T> T& get(int addr, T& t) {
+    memcpy(&t, mem + addr, sizeof(T));
+    return t;
+  }
+  template <typename T> const T& put(int addr, const T& t) {
+    memcpy(mem + addr, &t, sizeof(T));
+    return t;
+  }
+  uint16_t length() { return sizeof(mem); }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
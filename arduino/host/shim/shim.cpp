@@ -0,0 +1,90 @@
+#include "shim.h"
+#include <AltSoftSerial.h>
+#include <EEPROM.h>
+
+
+static unsigned long nowUs = 0;
+static int analogValues[32];
+static bool analogInit = false;
+static std::vector<uint8_t>* capture = nullptr;
+static unsigned long serialBytes = 0;
+static ShimRx serialRx;
+static ShimRx imuRx;  // Whichever port the IMU build reads (IMU_HW_UART)
+
+HardwareSerial Serial(&serialRx);
+HardwareSerial Serial1(&imuRx);
+EEPROMClass EEPROM;
+
+AltSoftSerial::AltSoftSerial() : rx(&imuRx) {}
+
+unsigned long millis() { return nowUs / 1000; }
+unsigned long micros() { return nowUs; }
+void delay(unsigned long ms) { nowUs += ms * 1000; }
+void delayMicroseconds(unsigned int us) { nowUs += us; }
+
+int analogRead(uint8_t pin) {
+  if (!analogInit) {
+    for (int& v : analogValues) v = 512;
+    analogInit = true;
+  }
+  return analogValues[pin & 31];
+}
+
+int digitalRead(uint8_t) { return LOW; }
+void digitalWrite(uint8_t, uint8_t) {}
+void pinMode(uint8_t, uint8_t) {}
+void attachInterrupt(uint8_t, void (*)(void), int) {}
+void detachInterrupt(uint8_t) {}
+
+size_t HardwareSerial::write(uint8_t b) {
+  if (this == &Serial) {
+    serialBytes++;
+    if (capture) capture->push_back(b);
+  }
+  return 1;
+}
+
+void shim_set_us(unsigned long us) { nowUs = us; }
+void shim_advance_us(unsigned long us) { nowUs += us; }
+
+void shim_set_analog(uint8_t pin, int value) {
+  analogRead(0);  // Fill defaults
+  analogValues[pin & 31] = value;
+}
+
+void shim_serial_capture(std::vector<uint8_t>* out) { capture = out; }
+unsigned long shim_serial_bytes() { return serialBytes; }
+
+void shim_imu_feed(const uint8_t* data, size_t len) {
+  imuRx.data = data;
+  imuRx.len = len;
+  imuRx.pos = 0;
+  imuRx.limit = 0;
+}
+
+void shim_imu_release(size_t n) {
+  imuRx.limit = (n >= imuRx.len - imuRx.limit) ? imuRx.len : imuRx.limit + n;
+}
+
+size_t shim_imu_pending() { return imuRx.len - imuRx.pos; }
+
+void shim_serial_feed(const char* text) {
+  serialRx.data = (const uint8_t*)text;
+  serialRx.len = strlen(text);
+  serialRx.pos = 0;
+  serialRx.limit = serialRx.len;
+}
+
+std::vector<uint8_t> shim_load_file(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    exit(1);
+  }
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
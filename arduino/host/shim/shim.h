@@ -0,0 +1,29 @@
+// Harness-side controls for the host shim
+#ifndef SHIM_H
+#define SHIM_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Virtual clock - millis()/micros() only move when the harness says so
+void shim_set_us(unsigned long us);
+void shim_advance_us(unsigned long us);
+
+// analogRead() result per pin (default 512)
+void shim_set_analog(uint8_t pin, int value);
+
+// Serial TX sink: captured into a buffer, or just counted
+void shim_serial_capture(std::vector<uint8_t>* out);  // nullptr = count only
+unsigned long shim_serial_bytes();                    // Total written since start
+
+// RX streams: the whole buffer is queued, shim_*_release() makes bytes available
+// (release everything at once with SIZE_MAX)
+void shim_imu_feed(const uint8_t* data, size_t len);
+void shim_imu_release(size_t n);
+size_t shim_imu_pending();  // Queued bytes not yet read by the firmware
+void shim_serial_feed(const char* text);
+
+// Load a whole file (WT61 byte dump); exits on error
+std::vector<uint8_t> shim_load_file(const char* path);
+
+#endif
@@ -0,0 +1,93 @@
+// TSV encoder check: every field kind, over the whole int16 range, against
+// what the float Print path (Print::print(v * scale, digits)) sends
+//
+//   tsv_check      exit status 0 if every column matches, else the first few
+//                  mismatches and 1
+//
+// The reference is the encoder comms.cpp had before going integer-only; the
+// shim's printFloat mirrors the AVR one, so a match here is a match on target.
+
+#include "shim.h"
+#include "config.h"
+#include "comms.h"
+#include <cstdio>
+#include <string>
+
+// Print into a string
+struct StringPrint : Print {
+  std::string s;
+  size_t write(uint8_t b) override {
+    s += (char)b;
+    return 1;
+  }
+};
+
+static void printReference(StringPrint& out, uint8_t i, int16_t v) {
+  if (i == FIELD_VBAT) {
+    out.print(v * 0.001, 2);
+  } else if (i == FIELD_SPEED || i == FIELD_ENG_TEMP || i == FIELD_IMU_TEMP) {
+    out.print(v * 0.1, 1);
+  } else if (i < FIELD_IMU_FIRST + 3) {
+    out.print(v * IMU_ACCEL_SCALE, 2);
+  } else if (i < FIELD_IMU_FIRST + 6) {
+    out.print(v * IMU_GYRO_SCALE, 2);
+  } else if (i < FIELD_IMU_FIRST + 9) {
+    out.print(v * IMU_ANGLE_SCALE, 2);
+  } else {
+    out.print(v);
+  }
+}
+
+static std::vector<uint8_t> wire;
+static unsigned long frames = 0;
+static unsigned long mismatches = 0;
+
+// One TSV frame with every field at v, t_ms at tMs; compares each column
+static void checkFrame(int16_t v, unsigned long tMs) {
+  int16_t fields[FIELD_COUNT];
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) fields[i] = v;
+  ImuRaw imu = {};
+  imu.ax = imu.ay = imu.az = v;
+  imu.gx = imu.gy = imu.gz = v;
+  imu.roll = imu.pitch = imu.yaw = v;
+  imu.lastUpdate = tMs;
+
+  uint8_t seq = frames++;
+  comms_send_fields(fields, imu, TLM_ALL);
+  while (comms_tx_pending() > 0) comms_update();
+
+  StringPrint ref;
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    if (i > 0) ref.write('\t');
+    printReference(ref, i, v);
+  }
+  ref.write('\t');
+  ref.print(seq);
+  ref.write('\t');
+  ref.print(tMs);
+  ref.write('\0');
+
+  std::string got(wire.begin(), wire.end());
+  wire.clear();
+  if (got != ref.s && mismatches++ < 5) {
+    for (char& c : got) if (c == '\t' || c == '\0') c = ' ';
+    for (char& c : ref.s) if (c == '\t' || c == '\0') c = ' ';
+    printf("v=%d t_ms=%lu\n  got: %s\n  ref: %s\n", v, tMs, got.c_str(), ref.s.c_str());
+  }
+}
+
+int main() {
+  shim_serial_capture(&wire);
+  Serial.txRoom = 0x7FFF;
+  config_init();
+  comms_init();
+  comms_set_format(FORMAT_TSV);
+
+  for (long v = -32768; v <= 32767; v++) checkFrame(v, (unsigned long)(v & 0xFFFF));
+  // t_ms over the uint32 range, up to the wrap
+  for (uint64_t t = 0; t <= 0xFFFFFFFFull; t += (t < 200000 ? 1 : 9973)) checkFrame(0, t);
+  checkFrame(0, 0xFFFFFFFFul);
+
+  printf("tsv_check: %lu frames, %lu mismatches\n", frames, mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
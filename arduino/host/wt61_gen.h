@@ -0,0 +1,63 @@
+// Synthetic WT61 byte streams for replay/bench when no capture is at hand
+#ifndef WT61_GEN_H
+#define WT61_GEN_H
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+// One 11-byte WT61 packet: 0x55, type, 4 x int16 LE, checksum
+static inline void wt61_packet(std::vector<uint8_t>& out, uint8_t type, int16_t v0, int16_t v1, int16_t v2, int16_t v3) {
+  uint8_t p[11] = { 0x55, type,
+    (uint8_t)v0, (uint8_t)(v0 >> 8), (uint8_t)v1, (uint8_t)(v1 >> 8),
+    (uint8_t)v2, (uint8_t)(v2 >> 8), (uint8_t)v3, (uint8_t)(v3 >> 8), 0 };
+  for (int i = 0; i < 10; i++) p[10] += p[i];
+  out.insert(out.end(), p, p + 11);
+}
+
+// `bursts` accel/gyro/angle triplets of a bike gently weaving (roll ±30°)
+// Values include 0x55 bytes in the payload now and then, as real data does
+static inline std::vector<uint8_t> wt61_stream(size_t bursts, unsigned rateHz = 20) {
+  std::vector<uint8_t> out;
+  out.reserve(bursts * 33);
+  const int16_t temp = (int16_t)((25.0 - 36.53) * 340);
+  for (size_t i = 0; i < bursts; i++) {
+    double t = (double)i / rateHz;
+    double roll = 30.0 * sin(t * 0.8);
+    double rollRate = 30.0 * 0.8 * cos(t * 0.8);
+    int16_t ax = (int16_t)(0.05 * sin(t * 3) * 2048);
+    int16_t ay = (int16_t)(sin(roll * M_PI / 180) * 2048);
+    int16_t az = (int16_t)(cos(roll * M_PI / 180) * 2048);
+    wt61_packet(out, 0x51, ax, ay, az, temp);
+    wt61_packet(out, 0x52, (int16_t)(rollRate / 2000 * 32768), 0x55, (int16_t)i, temp);
+    wt61_packet(out, 0x53, (int16_t)(roll / 180 * 32768), 0, (int16_t)(i * 37), temp);
+  }
+  return out;
+}
+
+// Flip each byte with probability p (line noise); returns bytes touched
+static inline size_t wt61_corrupt(std::vector<uint8_t>& data, double p, unsigned seed = 1) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  size_t touched = 0;
+  for (uint8_t& b : data) {
+    if (coin(rng) < p) {
+      b ^= (uint8_t)(1 + rng() % 255);
+      touched++;
+    }
+  }
+  return touched;
+}
+
+// Angle packets that survived intact (what a perfect parser could recover)
+static inline size_t wt61_intact_angles(const std::vector<uint8_t>& clean, const std::vector<uint8_t>& noisy) {
+  size_t n = 0;
+  for (size_t i = 0; i + 11 <= clean.size(); i += 11) {
+    if (clean[i + 1] == 0x53 && memcmp(&clean[i], &noisy[i], 11) == 0) n++;
+  }
+  return n;
+}
+
+#endif
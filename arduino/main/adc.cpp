@@ -0,0 +1,72 @@
+#include "adc.h"
+
+// ATmega328P: conversions auto-triggered by Timer0 overflow (the millis() tick),
+// results handled in ADC_vect - nothing ever waits on a conversion.
+// Other MCUs fall back to one blocking analogRead() per tick from adc_update().
+#if defined(__AVR_ATmega328P__)
+#define ADC_ISR 1
+#else
+#define ADC_ISR 0
+#endif
+
+static_assert((ADC_SLOTS & (ADC_SLOTS - 1)) == 0, "ADC_SLOTS must be a power of two");
+
+static uint8_t _pins[ADC_SLOTS];
+static AdcHandler volatile _handlers[ADC_SLOTS];  // NULL = idle slot, result dropped
+static uint8_t _slotCount = 0;
+static uint8_t _current = 0;  // Slot of the conversion in progress
+
+#if ADC_ISR
+// AVcc reference, pin's channel
+static inline uint8_t muxFor(uint8_t pin) {
+  return _BV(REFS0) | (pin - A0);
+}
+
+ISR(ADC_vect) {
+  uint16_t raw = ADC;
+  uint8_t slot = _current;
+  _current = (slot + 1) & (ADC_SLOTS - 1);
+
+  // The next trigger is a full tick away, long after the mux settles, so the
+  // channel for the next slot goes in now (idle slots keep the last one)
+  if (_current < _slotCount) ADMUX = muxFor(_pins[_current]);
+
+  AdcHandler handler = _handlers[slot];
+  if (handler) handler(raw);
+}
+#endif
+
+bool adc_attach(uint8_t pin, AdcHandler handler) {
+  if (_slotCount >= ADC_SLOTS) return false;
+
+  noInterrupts();
+  _pins[_slotCount] = pin;
+  _handlers[_slotCount] = handler;
+  _slotCount++;
+  interrupts();
+
+#if ADC_ISR
+  if (_slotCount == 1) {
+    // Auto-trigger on Timer0 overflow, prescaler 128 (125kHz ADC clock,
+    // 104us/conversion - finishes long before the next 1ms tick)
+    _current = 0;
+    ADMUX = muxFor(pin);
+    ADCSRB = _BV(ADTS2);
+    ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  }
+#endif
+  return true;
+}
+
+void adc_update() {
+#if !ADC_ISR
+  static unsigned long lastTick = 0;
+  unsigned long now = micros();
+  if (_slotCount == 0 || now - lastTick < 1024) return;  // One slot per millis() tick
+  lastTick = now;
+
+  uint8_t slot = _current;
+  _current = (slot + 1) & (ADC_SLOTS - 1);
+  if (slot < _slotCount) _handlers[slot](analogRead(_pins[slot]));
+#endif
+}
@@ -0,0 +1,26 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include <Arduino.h>
+
+// Background ADC sampling shared by the analog inputs
+// One conversion per millis() tick (16MHz/64/256 = 976Hz), rotating through
+// ADC_SLOTS fixed slots - every attached pin is sampled at ADC_PIN_HZ no
+// matter how many others are attached. Each result goes to its pin's handler:
+// from ADC_vect on the ATmega328P (keep it short: no Serial, no floats),
+// from adc_update() in loop() elsewhere.
+static const uint8_t ADC_SLOTS = 4;  // Power of two
+static const uint16_t ADC_PIN_HZ = 976 / ADC_SLOTS;
+
+typedef void (*AdcHandler)(uint16_t raw);
+
+// Sample `pin` (A0-A7) in the background from now on - call in setup
+// The first attach starts the ADC: blocking analogRead() seeds have to come
+// before it. Returns false when all slots are taken.
+bool adc_attach(uint8_t pin, AdcHandler handler);
+
+// Boards without the ADC_vect path: one analogRead() per tick - call in loop
+// No-op on the ATmega328P
+void adc_update();
+
+#endif
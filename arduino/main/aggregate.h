@@ -0,0 +1,62 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <Arduino.h>
+
+// Min / max / sum / count of N int16 channels over the samples between two
+// frames - constant time per sample, no sample storage
+// Channels set in WrapMask are angles in WT61 counts that wrap at ±180°: they
+// are tracked as the int16 difference from the first sample, so yaw crossing
+// the wrap stays continuous (valid while the spread stays under ±180°).
+template <uint8_t N, uint16_t WrapMask = 0>
+class Aggregate {
+  static_assert(N <= 16, "WrapMask has one bit per channel");
+
+ public:
+  void add(const int16_t* v) {
+    if (count_ == 0xFFFF) return;  // Saturated - sum would overflow next
+    bool first = count_ == 0;
+    for (uint8_t i = 0; i < N; i++) {
+      if (first) base_[i] = v[i];
+      int16_t r = rel(i, v[i]);
+      if (first || r < min_[i]) min_[i] = r;
+      if (first || r > max_[i]) max_[i] = r;
+      sum_[i] = first ? r : sum_[i] + r;
+    }
+    count_++;
+  }
+
+  uint16_t count() const { return count_; }
+
+  // Valid once count() > 0
+  int16_t min(uint8_t i) const { return out(i, min_[i]); }
+  int16_t max(uint8_t i) const { return out(i, max_[i]); }
+  int16_t mean(uint8_t i) const { return out(i, relMean(i)); }
+
+  // Whichever extreme lies farther from the mean: a pothole spike or a
+  // braking dip, signed, on top of the baseline
+  int16_t peak(uint8_t i) const {
+    int16_t m = relMean(i);
+    return out(i, (long)max_[i] - m >= (long)m - min_[i] ? max_[i] : min_[i]);
+  }
+
+  void reset() { count_ = 0; }
+
+ private:
+  static bool wraps(uint8_t i) { return (WrapMask >> i) & 1; }
+  int16_t rel(uint8_t i, int16_t v) const { return wraps(i) ? (int16_t)(v - base_[i]) : v; }
+  int16_t out(uint8_t i, int16_t r) const { return wraps(i) ? (int16_t)(base_[i] + r) : r; }
+
+  int16_t relMean(uint8_t i) const {
+    long half = count_ / 2;
+    return (sum_[i] + (sum_[i] < 0 ? -half : half)) / (long)count_;  // Rounded
+  }
+
+  int16_t base_[N];
+  int16_t min_[N];
+  int16_t max_[N];
+  long sum_[N];
+  uint16_t count_ = 0;
+};
+
+#endif
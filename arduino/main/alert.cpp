@@ -0,0 +1,171 @@
+#include "alert.h"
+#include "config.h"
+#include "comms.h"
+#include "voltage.h"
+#include "rpm.h"
+#include "fusion.h"
+
+// Rule table: command name, direction, defaults and the largest accepted
+// threshold, all in rule units (mV / RPM / deg / mg)
+struct RuleDef {
+  char name[6];
+  bool low;       // Raises below the threshold (else above)
+  uint16_t at;    // Default threshold
+  uint16_t hyst;  // Default hysteresis
+  uint16_t maxAt;
+};
+
+static const RuleDef RULES[ALERT_RULES] PROGMEM = {
+  { "VLOW",  true,  11800, 300, 20000 },  // Engine off: battery discharged
+  { "VHIGH", false, 15000, 300, 20000 },  // Regulator/rectifier fault
+  { "REV",   false,  9000, 300, 15000 },
+  { "LEAN",  false,    50,   5,    90 },
+  { "ACCEL", false,  3000, 500, 16000 },
+};
+
+// Thresholds converted to what each source is compared in: mV and RPM as
+// is, lean as |roll| in WT61 counts, accel as |a|^2 in counts^2 (no sqrt
+// per sample). raise = 0: rule off.
+struct RuleState {
+  uint16_t at, hyst;  // Rule units, as set
+  uint32_t raise, clear;
+};
+static RuleState rules[ALERT_RULES];
+static uint8_t active = 0;  // Bit per rule
+static uint8_t unsent = 0;  // Bit per rule: state change the TX queue had no room for yet
+static uint16_t eventValue[ALERT_RULES];     // Rule units, at the last crossing
+static unsigned long eventMs[ALERT_RULES];
+
+static const uint16_t ACCEL_COUNTS_PER_G = 2048;  // 32768 / 16g (IMU_ACCEL_SCALE)
+
+static bool isLow(uint8_t rule) {
+  return pgm_read_byte(&RULES[rule].low);
+}
+
+static uint32_t toCompare(uint8_t rule, uint16_t v) {
+  if (rule == ALERT_LEAN) return (uint32_t)v * 32768 / 180;
+  if (rule == ALERT_ACCEL) {
+    uint32_t counts = (uint32_t)v * ACCEL_COUNTS_PER_G / 1000;
+    return counts * counts;
+  }
+  return v;
+}
+
+static uint16_t toUnits(uint8_t rule, uint32_t v) {
+  if (rule == ALERT_LEAN) return (v * 180 + 16384) / 32768;
+  if (rule == ALERT_ACCEL) return (uint32_t)fusion_isqrt(v) * 1000 / ACCEL_COUNTS_PER_G;
+  return v;
+}
+
+static void applyRule(uint8_t rule, uint16_t at, uint16_t hyst) {
+  RuleState& r = rules[rule];
+  r.at = at;
+  r.hyst = hyst;
+  r.raise = at == 0 ? 0 : toCompare(rule, at);
+  r.clear = toCompare(rule, isLow(rule) ? at + hyst : at - hyst);
+  active &= ~(1 << rule);
+  unsent &= ~(1 << rule);
+}
+
+// Queue each pending state change; the rest retry from the next alert_update()
+static void sendPending() {
+  for (uint8_t i = 0; i < ALERT_RULES; i++) {
+    uint8_t bit = 1 << i;
+    if (!(unsent & bit)) continue;
+    if (!comms_send_alert(i, active & bit, eventValue[i], eventMs[i])) return;
+    unsent &= ~bit;
+  }
+}
+
+static void check(uint8_t rule, uint32_t v) {
+  const RuleState& r = rules[rule];
+  if (r.raise == 0) return;
+
+  uint8_t bit = 1 << rule;
+  bool low = isLow(rule);
+  bool crossed;
+  if (active & bit) {
+    crossed = low ? v >= r.clear : v <= r.clear;
+  } else {
+    crossed = low ? v < r.raise : v > r.raise;
+  }
+  if (!crossed) return;
+
+  // Only the latest state goes out if the last one is still waiting
+  active ^= bit;
+  unsent |= bit;
+  eventValue[rule] = toUnits(rule, v);
+  eventMs[rule] = millis();
+  sendPending();
+}
+
+void alert_init() {
+  Config& cfg = config_get();
+  for (uint8_t i = 0; i < ALERT_RULES; i++) {
+    uint16_t at = pgm_read_word(&RULES[i].at);
+    uint16_t hyst = pgm_read_word(&RULES[i].hyst);
+    if (config_valid() && cfg.alertAt[i] <= pgm_read_word(&RULES[i].maxAt)
+        && cfg.alertHyst[i] <= cfg.alertAt[i]) {
+      at = cfg.alertAt[i];
+      hyst = cfg.alertHyst[i];
+    } else {
+      cfg.alertAt[i] = at;  // Defaults, should another module save first
+      cfg.alertHyst[i] = hyst;
+    }
+    applyRule(i, at, hyst);
+  }
+}
+
+void alert_update() {
+  uint16_t mv = voltage_read_mv();
+  check(ALERT_VBAT_LOW, mv);
+  check(ALERT_VBAT_HIGH, mv);
+  int rpm = rpm_get();
+  check(ALERT_OVER_REV, rpm < 0 ? 0 : rpm);
+  if (unsent) sendPending();
+}
+
+void alert_check_imu(const ImuRaw& imu, const ImuRaw& raw) {
+  long roll = imu.roll;
+  check(ALERT_LEAN, roll < 0 ? -roll : roll);
+  check(ALERT_ACCEL, (uint32_t)((long)raw.ax * raw.ax) + (uint32_t)((long)raw.ay * raw.ay)
+                   + (uint32_t)((long)raw.az * raw.az));
+}
+
+bool alert_set(AlertRule rule, uint16_t at, uint16_t hyst) {
+  if (at > pgm_read_word(&RULES[rule].maxAt) || hyst > at) return false;
+  applyRule(rule, at, hyst);
+  return true;
+}
+
+uint16_t alert_get_at(AlertRule rule) {
+  return rules[rule].at;
+}
+
+uint16_t alert_get_hyst(AlertRule rule) {
+  return rules[rule].hyst;
+}
+
+int8_t alert_rule(const char* name) {
+  for (uint8_t i = 0; i < ALERT_RULES; i++) {
+    if (strcmp_P(name, RULES[i].name) == 0) return i;
+  }
+  return -1;
+}
+
+PGM_P alert_name(AlertRule rule) {
+  return RULES[rule].name;
+}
+
+bool alert_active(AlertRule rule) {
+  return active & (1 << rule);
+}
+
+void alert_save() {
+  Config& cfg = config_get();
+  for (uint8_t i = 0; i < ALERT_RULES; i++) {
+    cfg.alertAt[i] = rules[i].at;
+    cfg.alertHyst[i] = rules[i].hyst;
+  }
+  config_save();
+}
@@ -0,0 +1,49 @@
+#ifndef ALERT_H
+#define ALERT_H
+
+#include <Arduino.h>
+#include "imu.h"
+
+// Threshold alerts, checked on every sample of their source
+// A rule raises once its value crosses `at`, and clears only once it is back
+// past at -/+ hyst, so a value sitting on the threshold doesn't chatter.
+// Each crossing goes out as an alert event straight away (comms_send_alert),
+// not with the next telemetry frame.
+enum AlertRule : uint8_t {
+  ALERT_VBAT_LOW = 0,  // VLOW:  battery below at (mV)
+  ALERT_VBAT_HIGH,     // VHIGH: battery above at (mV) - charging fault
+  ALERT_OVER_REV,      // REV:   engine above at (RPM)
+  ALERT_LEAN,          // LEAN:  |roll| above at (deg)
+  ALERT_ACCEL,         // ACCEL: total acceleration above at (mg) - crash / pothole
+  ALERT_RULES,
+};
+
+// Load thresholds (stored config, else defaults) - call after config_init()
+void alert_init();
+
+// Check the voltage and RPM rules, and resend events the TX queue had no
+// room for - call in loop
+void alert_update();
+
+// Check the IMU rules against a fresh sample - call on each imu_update() hit
+// LEAN uses the calibrated roll (imu_get_data()), ACCEL the magnitude of the
+// uncalibrated accel (imu_get_raw()): gravity included, the same with or
+// without IMU_FUSION, and unchanged by the mounting
+void alert_check_imu(const ImuRaw& imu, const ImuRaw& raw);
+
+// Set a rule's threshold and hysteresis in its units (at = 0 turns it off)
+// Returns false if out of range; the rule restarts cleared
+bool alert_set(AlertRule rule, uint16_t at, uint16_t hyst);
+uint16_t alert_get_at(AlertRule rule);
+uint16_t alert_get_hyst(AlertRule rule);
+
+// Rule by its command name (VLOW, VHIGH, REV, LEAN, ACCEL), -1 if unknown
+int8_t alert_rule(const char* name);
+PGM_P alert_name(AlertRule rule);
+
+bool alert_active(AlertRule rule);
+
+// Persist thresholds (only changed EEPROM bytes are written)
+void alert_save();
+
+#endif
@@ -1,111 +1,1043 @@
 #include "comms.h"
+#include "voltage.h"
+#include "sched.h"
+#include "config.h"
+#include "crc16.h"
+#include "imubatch.h"
+#include "aggregate.h"
+#include "ringbuf.h"
+#include "fusion.h"
+#include "alert.h"
 
 // Pi communication uses hardware Serial (pins 0/1)
-// Baud rate - 115200 is reasonable for duplex with Pi
+// Boot baud rate - 115200 is reasonable for duplex with Pi, and what a Pi that
+// doesn't send CMD:HELLO expects. Never saved: every boot starts here.
 static const long BAUD_RATE = 115200;
 
+// CMD:HELLO rates, in 100 baud; bit i of the `bauds` masks is LINK_BAUDS[i].
+// 250k/500k/1M divide 16MHz exactly, 115200 is 2.1% off.
+static const uint16_t LINK_BAUDS[] PROGMEM = { 1152, 2500, 5000, 10000 };
+static const uint8_t LINK_BAUD_COUNT = sizeof(LINK_BAUDS) / sizeof(LINK_BAUDS[0]);
+static const uint8_t LINK_BAUD_MASK = (1 << LINK_BAUD_COUNT) - 1;
+
+// Back to BAUD_RATE if the Pi doesn't confirm a new rate with a known command
+// within LINK_CONFIRM_MS, or when LINK_GARBAGE_MAX bytes no command line holds
+// (non-ASCII: framing errors, the Pi went back to another rate) arrive within
+// LINK_GARBAGE_MS. The core's RX interrupt drops the UART error flags, so the
+// bytes are all there is to go on.
+static const unsigned long LINK_CONFIRM_MS = 2000;
+static const unsigned long LINK_GARBAGE_MS = 1000;
+static const uint8_t LINK_GARBAGE_MAX = 8;
+
+static uint8_t linkBaud = 0;         // LINK_BAUDS index in use
+static uint8_t linkNext = 0;         // Chosen by HELLO, applied once its ACK is out
+static bool linkConfirmed = true;
+static unsigned long linkSince = 0;  // Switch time, then start of the garbage window
+static uint8_t rxGarbage = 0;
+
 // Command buffer
 static const int CMD_BUF_SIZE = 64;
 static char cmdBuf[CMD_BUF_SIZE];
 static int cmdIndex = 0;
-static bool cmdReady = false;
 
 // Connection tracking
 static unsigned long lastRxTime = 0;
+static uint16_t rxOverflows = 0;
+
+// Telemetry format (TSV by default - easy to eyeball in a serial monitor)
+static TelemetryFormat format = FORMAT_TSV;
+static const uint8_t FORMAT_MASK = (1 << FORMAT_TSV) | (1 << FORMAT_BINARY) | (1 << FORMAT_BATCH);
+
+// Binary frame layout (see PROTOCOL.md):
+// [0xA5 0x5A] [version] [type] [seq] [len] [payload...] [crc16 lo] [crc16 hi]
+// Sync bytes are >0x7F so they never collide with ASCII text lines
+static const uint8_t FRAME_SYNC0 = 0xA5;
+static const uint8_t FRAME_SYNC1 = 0x5A;
+static const uint8_t PROTOCOL_VERSION = 4;  // 2: telemetry payload carries t_ms, 3: speed field, 4: temperatures
+static const uint8_t FRAME_TELEMETRY = 0x01;
+static const uint8_t FRAME_IMU_BATCH = 0x02;
+static const uint8_t FRAME_ALERT = 0x03;
+static const uint8_t FRAME_RANGE = 0x04;
+
+// Field indices are in comms.h
+static const uint16_t MASK_IMU = 0x03FE;    // Bits 1-9
+static const uint16_t MASK_ANGLES = 0x0380; // Bits 7-9: roll/pitch/yaw, wrap at ±180°
+static const uint8_t FIELD_AGG_COUNT = FIELD_IMU_FIRST + 9;  // V_bat + IMU are aggregated
+
+// Binary field mask bits for a set of TLM_* groups
+static uint16_t fieldMask(uint8_t groups) {
+  uint16_t mask = 0;
+  if (groups & TLM_VOLTAGE) mask |= 1 << FIELD_VBAT;
+  if (groups & TLM_IMU)     mask |= MASK_IMU;
+  if (groups & TLM_RPM)     mask |= 1 << FIELD_RPM;
+  if (groups & TLM_GEAR)    mask |= 1 << FIELD_GEAR;
+  if (groups & TLM_SPEED)   mask |= 1 << FIELD_SPEED;
+  if (groups & TLM_ENG_TEMP) mask |= 1 << FIELD_ENG_TEMP;
+  if (groups & TLM_IMU_TEMP) mask |= 1 << FIELD_IMU_TEMP;
+  return mask;
+}
+
+// Binary fixed-point: IMU fields go out as raw WT61 counts so the Pi applies
+// the datasheet scale (IMU.md), voltage goes out in millivolts, speed in 0.1 km/h,
+// temperatures in 0.1 °C
+
+// Delta frames: per-field deadband in field units (raw counts / mV / RPM / 0.1 km/h)
+// Roughly one printed TSV digit for the IMU, anything finer is sensor noise
+static const int16_t DEADBAND[FIELD_COUNT] PROGMEM = {
+  50,           // V_bat: 50mV
+  20, 20, 20,   // Accel: ~0.01g
+  10, 10, 10,   // Gyro: ~0.6 deg/s
+  9, 9, 9,      // Euler: ~0.05 deg
+  25,           // RPM
+  0,            // Gear: any change
+  5,            // Speed: 0.5 km/h
+  5, 5,         // Engine / IMU temperature: 0.5 °C
+};
+static const unsigned long KEYFRAME_INTERVAL_MS = 1000;
+static bool deltaEnabled = false;
+static int16_t lastSent[FIELD_COUNT];
+static uint16_t keyframePending = 0xFFFF;  // Fields still owed a keyframe send
+static unsigned long lastKeyframe = 0;
+
+// Frame timing (changed at runtime by CMD:MODE)
+static TelemetryMode txMode = MODE_EVENT;
+
+// Batched IMU samples (FORMAT_BATCH) - 8 x 20 bytes, one 165-byte burst
+static const uint8_t IMU_BATCH_SIZE = 8;
+static ImuBatch<IMU_BATCH_SIZE> imuBatch;
+static unsigned long lastBatchedUs = 0;  // Stamp of the last sample queued
+
+// Between-frame IMU aggregate (CMD:AGG) - roll/pitch/yaw wrap at ±180°
+static const uint16_t AGG_WRAP_ANGLES = 0x01C0;  // Channels 6-8
+static Aggregate<9, AGG_WRAP_ANGLES> imuAgg;
+static TelemetryStat frameStat = STAT_LAST;
+static bool rangeEnabled = false;
+
+static uint8_t txSeq = 0;
+static uint16_t txCrc = 0;
+
+// TX queue: every frame and text line is built here first, then handed to
+// Serial only as fast as its 64-byte buffer frees up (availableForWrite), so
+// loop() never blocks on the wire and AltSoftSerial RX never starves.
+// A frame that doesn't fit in the space left is dropped whole and counted,
+// never sent half - on the Pi it shows up as a sequence gap.
+// The last TX_RESERVE bytes are kept for alerts, so a queue backed up with
+// telemetry never holds one back.
+static const uint16_t TX_BUF_SIZE = 256;  // Largest frame: a 173-byte IMU batch
+static const uint16_t TX_RESERVE = 64;    // Two ALERT lines
+static_assert(6 + 1 + 4 + IMU_BATCH_SIZE * sizeof(ImuBatchSample) + 2 <= TX_BUF_SIZE - TX_RESERVE,
+              "IMU batch frame must fit the TX queue");
+
+class TxQueue : public Print {
+ public:
+  // Start a frame: bytes go into the ring's free slots, unpublished,
+  // leaving `reserve` of them spare
+  void begin(uint16_t reserve = TX_RESERVE) {
+    uint16_t space = ring.space();
+    room = space > reserve ? space - reserve : 0;
+    len = 0;
+    overflow = false;
+  }
+
+  size_t write(uint8_t b) override {
+    if (len >= room) {
+      overflow = true;
+      return 0;
+    }
+    ring.slot(len++) = b;
+    return 1;
+  }
+
+  size_t write(const uint8_t* buf, size_t n) override {
+    if (n > (size_t)(room - len)) {
+      overflow = true;
+      return 0;
+    }
+    for (size_t i = 0; i < n; i++) ring.slot(len++) = buf[i];
+    return n;
+  }
+  using Print::write;
+
+  // Queue the frame built since begin(), or drop it if it didn't fit
+  bool commit() {
+    bool queued = !overflow;
+    if (queued) {
+      ring.publish(len);
+    } else {
+      drops++;
+    }
+    drain();
+    return queued;
+  }
+
+  // Hand Serial as much as it takes without blocking
+  void drain() {
+    int free = Serial.availableForWrite();
+    uint8_t b;
+    while (free-- > 0 && ring.pop(b)) Serial.write(b);
+  }
+
+  uint16_t pending() const { return ring.count(); }
+
+  uint16_t drops = 0;  // Running total, wraps at 65535
+
+ private:
+  RingBuffer<uint8_t, TX_BUF_SIZE> ring;  // Loop-only, so 16-bit indices are fine
+  uint16_t room = 0;  // Free slots when the frame began
+  uint16_t len = 0;   // Bytes in the frame being built
+  bool overflow = false;
+};
+static TxQueue tx;
 
 void comms_init() {
   Serial.begin(BAUD_RATE);
   cmdIndex = 0;
-  cmdReady = false;
+
+  // Pick up where CMD:FORMAT left off (call config_init() first)
+  uint8_t stored = config_get().format;
+  if (config_valid() && stored <= FORMAT_BATCH) format = (TelemetryFormat)stored;
+}
+
+// Command dispatch
+// CMD:NAME:key=value:... is split in place in cmdBuf (':' -> '\0'), handlers
+// look their arguments up by key. No String, no copies.
+enum CmdStatus : uint8_t {
+  CMD_OK = 0,
+  CMD_ERR = 1,      // Known command, missing or out-of-range argument
+  CMD_UNKNOWN = 2,
+};
+
+static const uint8_t CMD_MAX_ARGS = 4;
+static const char* cmdArgs[CMD_MAX_ARGS];
+static uint8_t cmdArgCount = 0;
+
+// Optional ":key=value" pairs on the ACK, set by a handler (e.g. the value
+// actually applied). Most set one, HELLO lists its capabilities.
+static const uint8_t CMD_MAX_REPLIES = 4;
+static PGM_P replyKeys[CMD_MAX_REPLIES];
+static long replyValues[CMD_MAX_REPLIES];
+static uint8_t replyCount = 0;
+
+static void setReply(PGM_P key, long value) {
+  if (replyCount == CMD_MAX_REPLIES) return;
+  replyKeys[replyCount] = key;
+  replyValues[replyCount++] = value;
+}
+
+// Value of key=... among the current arguments, NULL if absent
+static const char* cmdArg(PGM_P key) {
+  size_t len = strlen_P(key);
+  for (uint8_t i = 0; i < cmdArgCount; i++) {
+    if (strncmp_P(cmdArgs[i], key, len) == 0 && cmdArgs[i][len] == '=') {
+      return cmdArgs[i] + len + 1;
+    }
+  }
+  return NULL;
+}
+
+// Integer argument within [lo, hi]; false if absent, malformed or out of range
+static bool cmdArgLong(PGM_P key, long lo, long hi, long& out) {
+  const char* s = cmdArg(key);
+  if (s == NULL || *s == '\0') return false;
+  char* end;
+  long v = strtol(s, &end, 10);
+  if (*end != '\0' || v < lo || v > hi) return false;
+  out = v;
+  return true;
+}
+
+// CMD:PING[:hb=<n>] - liveness check; the Pi's heartbeat tags itself with hb,
+// echoed so its ACK can be told from the reply to any other PING
+static CmdStatus cmdPing() {
+  long hb;
+  if (cmdArgLong(PSTR("hb"), 0, 255, hb)) setReply(PSTR("hb"), hb);
+  return CMD_OK;
+}
+
+// CMD:FORMAT:mode=TSV|BIN|BATCH
+static CmdStatus cmdFormat() {
+  const char* mode = cmdArg(PSTR("mode"));
+  if (mode == NULL) return CMD_ERR;
+  if (strcmp_P(mode, PSTR("BIN")) == 0) {
+    comms_set_format(FORMAT_BINARY);
+  } else if (strcmp_P(mode, PSTR("BATCH")) == 0) {
+    comms_set_format(FORMAT_BATCH);
+  } else if (strcmp_P(mode, PSTR("TSV")) == 0) {
+    comms_set_format(FORMAT_TSV);
+  } else {
+    return CMD_ERR;
+  }
+  config_get().format = format;
+  config_save();
+  return CMD_OK;
+}
+
+// CMD:HELLO:bauds=<mask>[:fmts=<mask>] - link negotiation, sent by the Pi on connect
+// Replies with the protocol version and what this firmware takes, then moves to
+// the fastest baud in both masks. fmts: bit per TelemetryFormat the Pi decodes.
+static CmdStatus cmdHello() {
+  long bauds, fmts = FORMAT_MASK;
+  if (!cmdArgLong(PSTR("bauds"), 1, 0xFF, bauds)) return CMD_ERR;
+  if (cmdArg(PSTR("fmts")) != NULL && !cmdArgLong(PSTR("fmts"), 1, 0xFF, fmts)) return CMD_ERR;
+  uint8_t shared = bauds & LINK_BAUD_MASK;
+  if (shared == 0) return CMD_ERR;
+
+  uint8_t best = 0;
+  while (shared >>= 1) best++;
+  linkNext = best;
+
+  // Stop frames the Pi can't decode now, not at its CMD:FORMAT (not saved)
+  if (!(fmts & (1 << format))) comms_set_format(FORMAT_TSV);
+
+  setReply(PSTR("ver"), PROTOCOL_VERSION);
+  setReply(PSTR("fmts"), FORMAT_MASK);
+  setReply(PSTR("bauds"), LINK_BAUD_MASK);
+  setReply(PSTR("baud"), (long)pgm_read_word(&LINK_BAUDS[best]) * 100);
+  return CMD_OK;
+}
+
+// CMD:DELTA:on=1|0
+static CmdStatus cmdDelta() {
+  long on;
+  if (!cmdArgLong(PSTR("on"), 0, 1, on)) return CMD_ERR;
+  comms_set_delta(on != 0);
+  return CMD_OK;
+}
+
+// CMD:AGG:stat=LAST|MEAN|PEAK[:range=1|0]
+static CmdStatus cmdAgg() {
+  const char* stat = cmdArg(PSTR("stat"));
+  if (stat == NULL) return CMD_ERR;
+  TelemetryStat s;
+  if (strcmp_P(stat, PSTR("LAST")) == 0) {
+    s = STAT_LAST;
+  } else if (strcmp_P(stat, PSTR("MEAN")) == 0) {
+    s = STAT_MEAN;
+  } else if (strcmp_P(stat, PSTR("PEAK")) == 0) {
+    s = STAT_PEAK;
+  } else {
+    return CMD_ERR;
+  }
+  long range = rangeEnabled;
+  if (cmdArg(PSTR("range")) != NULL && !cmdArgLong(PSTR("range"), 0, 1, range)) return CMD_ERR;
+  comms_set_stat(s);
+  comms_set_range(range != 0);
+  return CMD_OK;
+}
+
+// CMD:MODE:tx=EVENT|TIMED
+static CmdStatus cmdMode() {
+  const char* tx = cmdArg(PSTR("tx"));
+  if (tx == NULL) return CMD_ERR;
+  if (strcmp_P(tx, PSTR("EVENT")) == 0) {
+    txMode = MODE_EVENT;
+  } else if (strcmp_P(tx, PSTR("TIMED")) == 0) {
+    txMode = MODE_TIMED;
+  } else {
+    return CMD_ERR;
+  }
+  return CMD_OK;
+}
+
+// CMD:SET_RATE[:ch=<channel>]:hz=<1-100> | ...:ms=<period>
+// Channel defaults to TLM; ms=0 turns a channel off (IMU: every packet)
+// New rates are persisted straight away
+static CmdStatus cmdSetRate() {
+  SchedChannel ch = CH_TELEMETRY;
+  const char* name = cmdArg(PSTR("ch"));
+  if (name != NULL) {
+    int8_t found = sched_channel(name);
+    if (found < 0) return CMD_ERR;
+    ch = (SchedChannel)found;
+  }
+
+  long v;
+  uint16_t period;
+  if (cmdArgLong(PSTR("hz"), 1, 100, v)) {
+    period = 1000 / v;
+  } else if (cmdArgLong(PSTR("ms"), 0, 60000L, v)) {
+    period = v;
+  } else {
+    return CMD_ERR;
+  }
+  if (ch == CH_TELEMETRY && period < 10) return CMD_ERR;  // Frames need a floor
+
+  sched_set_period(ch, period);
+  sched_save();
+  setReply(PSTR("ms"), period);
+  return CMD_OK;
+}
+
+// CMD:SET_SMOOTH:n=<1-32> - rounded down to a power of two, ACK carries the size used
+static CmdStatus cmdSetSmooth() {
+  long n;
+  if (!cmdArgLong(PSTR("n"), 1, 32, n)) return CMD_ERR;
+  setReply(PSTR("n"), voltage_set_smoothing(n));
+  return CMD_OK;
+}
+
+// CMD:CALIBRATE | CMD:CALIBRATE:n=<1-255>
+static CmdStatus cmdCalibrate() {
+  long n;
+  if (cmdArg(PSTR("n")) == NULL) {
+    imu_calibrate_start();
+  } else if (cmdArgLong(PSTR("n"), 1, 255, n)) {
+    imu_calibrate_start(n);
+  } else {
+    return CMD_ERR;
+  }
+  return CMD_OK;
+}
+
+// CMD:ZERO_YAW - current heading becomes 0
+static CmdStatus cmdZeroYaw() {
+  imu_zero_yaw();
+  return CMD_OK;
+}
+
+// CMD:FUSION:on=1|0[:k=<1-500>] - onboard roll/pitch filter, k = gain in 1/1000
+static CmdStatus cmdFusion() {
+  long on, k;
+  if (!cmdArgLong(PSTR("on"), 0, 1, on)) return CMD_ERR;
+  if (cmdArg(PSTR("k")) != NULL) {
+    if (!cmdArgLong(PSTR("k"), 1, 500, k)) return CMD_ERR;
+    fusion_set_gain((k * 32768 + 500) / 1000);
+  }
+  imu_set_fusion(on != 0);
+  setReply(PSTR("k"), ((long)fusion_get_gain() * 1000 + 16384) / 32768);
+  return CMD_OK;
+}
+
+// CMD:ALERT:rule=<name>:at=<value>[:hyst=<value>] - at=0 turns the rule off
+// Units per rule (alert.h); hysteresis stays as it was if not given. Persisted.
+static CmdStatus cmdAlert() {
+  const char* name = cmdArg(PSTR("rule"));
+  if (name == NULL) return CMD_ERR;
+  int8_t found = alert_rule(name);
+  if (found < 0) return CMD_ERR;
+  AlertRule rule = (AlertRule)found;
+
+  long at;
+  long hyst = alert_get_hyst(rule);
+  if (!cmdArgLong(PSTR("at"), 0, 65535L, at)) return CMD_ERR;
+  if (cmdArg(PSTR("hyst")) != NULL && !cmdArgLong(PSTR("hyst"), 0, 65535L, hyst)) return CMD_ERR;
+  if (!alert_set(rule, at, hyst)) return CMD_ERR;
+  alert_save();
+  setReply(PSTR("hyst"), hyst);
+  return CMD_OK;
+}
+
+// CMD:PERF (one-shot) | CMD:PERF:ms=<interval> (also periodic, 0 = off)
+static CmdStatus cmdPerf() {
+  long ms;
+  if (cmdArg(PSTR("ms")) != NULL) {
+    if (!cmdArgLong(PSTR("ms"), 0, 60000L, ms)) return CMD_ERR;
+    sched_set_period(CH_STATS, ms);  // Session only - SET_RATE:ch=STATS persists
+  }
+  PerfStats stats;
+  perf_get(stats);
+  comms_send_perf(stats);
+  return CMD_OK;
+}
+
+typedef CmdStatus (*CmdHandler)();
+
+struct CmdEntry {
+  char name[11];
+  CmdHandler handler;
+};
+
+static const CmdEntry COMMANDS[] PROGMEM = {
+  { "PING",       cmdPing },
+  { "HELLO",      cmdHello },
+  { "FORMAT",     cmdFormat },
+  { "DELTA",      cmdDelta },
+  { "AGG",        cmdAgg },
+  { "MODE",       cmdMode },
+  { "SET_RATE",   cmdSetRate },
+  { "SET_SMOOTH", cmdSetSmooth },
+  { "CALIBRATE",  cmdCalibrate },
+  { "ZERO_YAW",   cmdZeroYaw },
+  { "FUSION",     cmdFusion },
+  { "PERF",       cmdPerf },
+  { "ALERT",      cmdAlert },
+};
+static const uint8_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void dispatchCommand(char* line) {
+  // Split on ':' in place: [CMD] NAME [key=value...]
+  char* name = line;
+  if (strncmp_P(line, PSTR("CMD:"), 4) == 0) name += 4;
+  cmdArgCount = 0;
+  for (char* p = name; *p != '\0'; p++) {
+    if (*p != ':') continue;
+    *p = '\0';
+    if (cmdArgCount < CMD_MAX_ARGS) cmdArgs[cmdArgCount++] = p + 1;
+  }
+
+  CmdStatus status = CMD_UNKNOWN;
+  replyCount = 0;
+  for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+    if (strcmp_P(name, COMMANDS[i].name) == 0) {
+      CmdHandler handler = (CmdHandler)pgm_read_ptr(&COMMANDS[i].handler);
+      status = handler();
+      linkConfirmed = true;  // Readable at this rate (a HELLO switch clears it again)
+      break;
+    }
+  }
+
+  // ACK:NAME:STATUS[:key=value...] - matches ACK_PATTERN on the Pi
+  tx.begin();
+  tx.print(F("ACK:"));
+  tx.print(name);
+  if (status == CMD_OK) {
+    tx.print(F(":OK"));
+  } else if (status == CMD_ERR) {
+    tx.print(F(":ERR"));
+  } else {
+    tx.print(F(":UNKNOWN"));
+  }
+  for (uint8_t i = 0; status == CMD_OK && i < replyCount; i++) {
+    tx.write(':');
+    tx.print(reinterpret_cast<const __FlashStringHelper*>(replyKeys[i]));
+    tx.write('=');
+    tx.print(replyValues[i]);
+  }
+  tx.println();
+  tx.commit();
+}
+
+// Serial at LINK_BAUDS[i]. Blocks until the queue is out (a HELLO ACK last, at
+// most TX_BUF_SIZE bytes: ~22ms at 115200) - the Pi switches once it reads it.
+static void linkSwitch(uint8_t i) {
+  while (tx.pending() > 0) tx.drain();
+  Serial.flush();
+  Serial.begin((long)pgm_read_word(&LINK_BAUDS[i]) * 100);
+  linkBaud = linkNext = i;
+  linkConfirmed = (i == 0);
+  linkSince = millis();
+  rxGarbage = 0;
+  cmdIndex = 0;  // Whatever came in mid-switch is garbled
 }
 
 bool comms_update() {
+  tx.drain();
+
+  if (linkBaud != 0) {
+    unsigned long now = millis();
+    if (!linkConfirmed && now - linkSince >= LINK_CONFIRM_MS) {
+      linkSwitch(0);
+    } else if (linkConfirmed && now - linkSince >= LINK_GARBAGE_MS) {
+      linkSince = now;
+      rxGarbage = 0;
+    }
+  }
+
   while (Serial.available()) {
     char c = Serial.read();
     lastRxTime = millis();
 
+    // Not part of any command line: drop it with the line it landed in
+    uint8_t b = c;
+    if (b >= 0x80 || (b < ' ' && c != '\n' && c != '\r' && c != '\t')) {
+      cmdIndex = 0;
+      if (linkBaud != 0 && ++rxGarbage >= LINK_GARBAGE_MAX) {
+        linkSwitch(0);
+        return false;
+      }
+      continue;
+    }
+
     if (c == '\n' || c == '\r') {
       if (cmdIndex > 0) {
         cmdBuf[cmdIndex] = '\0';
-        cmdReady = true;
         cmdIndex = 0;
+        dispatchCommand(cmdBuf);
+        if (linkNext != linkBaud) linkSwitch(linkNext);
         return true;
       }
     } else if (cmdIndex < CMD_BUF_SIZE - 1) {
       cmdBuf[cmdIndex++] = c;
+    } else {
+      rxOverflows++;  // Overflow: drop extra chars, but count them
     }
-    // else: overflow, silently drop extra chars
   }
   return false;
 }
 
-void comms_send_telemetry(float voltage, const ImuData& imu, bool imu_valid, int rpm, int gear) {
-  // Field 0: voltage
-  Serial.print(voltage, 2);
-  Serial.write('\t');
-
-  if (imu_valid) {
-    // Fields 1-3: acceleration
-    Serial.print(imu.ax, 2);
-    Serial.write('\t');
-    Serial.print(imu.ay, 2);
-    Serial.write('\t');
-    Serial.print(imu.az, 2);
-    Serial.write('\t');
-
-    // Fields 4-6: angular velocity
-    Serial.print(imu.gx, 2);
-    Serial.write('\t');
-    Serial.print(imu.gy, 2);
-    Serial.write('\t');
-    Serial.print(imu.gz, 2);
-    Serial.write('\t');
-
-    // Fields 7-9: euler angles
-    Serial.print(imu.roll, 2);
-    Serial.write('\t');
-    Serial.print(imu.pitch, 2);
-    Serial.write('\t');
-    Serial.print(imu.yaw, 2);
+static void frameWrite(uint8_t b) {
+  txCrc = crc16_update(txCrc, b);
+  tx.write(b);
+}
+
+static void frameWriteI16(int16_t v) {
+  frameWrite((uint16_t)v & 0xFF);
+  frameWrite((uint16_t)v >> 8);
+}
+
+static void frameBegin(uint8_t type, uint8_t len, uint16_t reserve = TX_RESERVE) {
+  tx.begin(reserve);
+  tx.write(FRAME_SYNC0);
+  tx.write(FRAME_SYNC1);
+  txCrc = CRC16_INIT;  // CRC covers version..payload, not the sync bytes
+  frameWrite(PROTOCOL_VERSION);
+  frameWrite(type);
+  frameWrite(txSeq++);
+  frameWrite(len);
+}
+
+static bool frameEnd() {
+  uint16_t crc = txCrc;
+  tx.write(crc & 0xFF);
+  tx.write(crc >> 8);
+  return tx.commit();
+}
+
+static void sendTelemetryBinary(const int16_t* fields, uint16_t mask, unsigned long tMs) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    if (mask & (1 << i)) count++;
+  }
+
+  frameBegin(FRAME_TELEMETRY, 2 + 4 + count * 2);
+  frameWriteI16(mask);
+  frameWriteI16(tMs & 0xFFFF);
+  frameWriteI16(tMs >> 16);
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    if (mask & (1 << i)) frameWriteI16(fields[i]);
+  }
+  frameEnd();
+}
+
+// Range payload: mask, then min and max per set bit
+static void sendRange(const int16_t* lo, const int16_t* hi, uint16_t mask) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < FIELD_AGG_COUNT; i++) {
+    if (mask & (1 << i)) count++;
+  }
+
+  frameBegin(FRAME_RANGE, 2 + count * 4);
+  frameWriteI16(mask);
+  for (uint8_t i = 0; i < FIELD_AGG_COUNT; i++) {
+    if (!(mask & (1 << i))) continue;
+    frameWriteI16(lo[i]);
+    frameWriteI16(hi[i]);
+  }
+  frameEnd();
+}
+
+static void sendImuBatch() {
+  uint8_t count = imuBatch.count();
+  frameBegin(FRAME_IMU_BATCH, 1 + 4 + count * sizeof(ImuBatchSample));
+  frameWrite(count);
+  unsigned long t0 = imuBatch.firstUs();
+  frameWriteI16(t0 & 0xFFFF);
+  frameWriteI16(t0 >> 16);
+  for (uint8_t i = 0; i < count; i++) {
+    const ImuBatchSample& s = imuBatch[i];
+    frameWriteI16(s.dtUs);
+    for (uint8_t j = 0; j < 9; j++) frameWriteI16(s.v[j]);
+  }
+  frameEnd();
+  imuBatch.clear();
+}
+
+// TSV text, integer-only: the float Print path cost most of the frame time.
+// Digits match what Print::print(v * scale, 2) gives, byte for byte, so the
+// Pi parses it unchanged. Raw counts scale exactly by an integer ratio; ties
+// (x.xx5, and float's near-ties within a count of one) are left to printFloat's
+// own rounding steps, since float resolves them either way.
+// Whole frame is laid out on the stack and queued in one write. Longest:
+// -32.77, 3x -16.00, 3x -2000.00, 3x -180.00, -32768 x2, 3x -3276.8, 255, 4294967295
+static const uint8_t TSV_FRAME_MAX = 6 + 3 * 6 + 3 * 8 + 3 * 7 + 6 + 6 + 3 * 7 + 3 + 10 + 16 + 1;
+
+// "00" "01" ... "99", two digits per lookup (one divide per pair)
+static const char DIGIT_PAIRS[] PROGMEM =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static char* putPair(char* p, uint8_t r) {
+  *p++ = pgm_read_byte(&DIGIT_PAIRS[r * 2]);
+  *p++ = pgm_read_byte(&DIGIT_PAIRS[r * 2 + 1]);
+  return p;
+}
+
+// Decimal digits of n, no leading zeros; 32-bit divides only while n needs them
+static char* putUint(char* p, uint32_t n) {
+  char digits[10];
+  uint8_t i = sizeof(digits);
+  while (n > 0xFFFF) {
+    uint32_t q = n / 100;
+    putPair(&digits[i -= 2], n - q * 100);
+    n = q;
+  }
+  uint16_t m = n;
+  while (m >= 100) {
+    uint16_t q = m / 100;
+    putPair(&digits[i -= 2], m - q * 100);
+    m = q;
+  }
+  if (m >= 10) {
+    putPair(&digits[i -= 2], m);
   } else {
-    // Empty fields for stale IMU (9 tabs for 9 empty fields)
-    Serial.print(F("\t\t\t\t\t\t\t\t"));
+    digits[--i] = '0' + m;
   }
+  memcpy(p, &digits[i], sizeof(digits) - i);
+  return p + sizeof(digits) - i;
+}
 
-  // Fields 10-11: RPM and gear
-  Serial.write('\t');
-  Serial.print(rpm);
-  Serial.write('\t');
-  Serial.print(gear);
+static char* putInt(char* p, int16_t v) {
+  if (v < 0) *p++ = '-';
+  return putUint(p, v < 0 ? -(int32_t)v : v);
+}
+
+// Hundredths of |x| the way Print::printFloat(x, 2) arrives at them
+static uint32_t floatHundredths(float x) {
+  if (x < 0) x = -x;
+  x += 0.5f / 10 / 10;
+  uint32_t whole = (uint32_t)x;
+  float rem = (x - whole) * 10;
+  uint8_t tenths = (uint8_t)rem;
+  rem = (rem - tenths) * 10;
+  return whole * 100 + tenths * 10 + (uint8_t)rem;
+}
+
+// value / 10^decimals, as whole.frac (the sign is the caller's)
+static char* putDecimal(char* p, uint32_t value, uint8_t decimals) {
+  if (decimals == 1) {
+    uint32_t whole = value / 10;
+    p = putUint(p, whole);
+    *p++ = '.';
+    *p++ = '0' + (value - whole * 10);
+    return p;
+  }
+  uint32_t whole = value / 100;
+  p = putUint(p, whole);
+  *p++ = '.';
+  return putPair(p, value - whole * 100);
+}
+
+// v * MUL / 2^SHIFT hundredths - the IMU scales are exact in this form
+// (IMU_*_SCALE * 100 = MUL / 2^SHIFT), `scale` is only used on ties
+template <uint16_t MUL, uint8_t SHIFT>
+static char* putScaled(char* p, int16_t v, float scale) {
+  if (v < 0) *p++ = '-';
+  uint32_t x = (uint32_t)(v < 0 ? -(int32_t)v : v) * MUL;
+  int16_t fromHalf = (int16_t)(x & ((1UL << SHIFT) - 1)) - (1 << (SHIFT - 1));
+  uint32_t hundredths;
+  if (fromHalf >= -1 && fromHalf <= 1) {
+    hundredths = floatHundredths(v * scale);
+  } else {
+    hundredths = (x + (1UL << (SHIFT - 1))) >> SHIFT;
+  }
+  return putDecimal(p, hundredths, 2);
+}
+
+static_assert(16.0 / 32768 * 100 == 25.0 / 512 && 2000.0 / 32768 * 100 == 3125.0 / 512 &&
+              180.0 / 32768 * 100 == 1125.0 / 2048, "TSV IMU ratios must match imu.h scales");
+
+// Scale to engineering units only here (human-readable path)
+static char* putTsvField(char* p, uint8_t i, int16_t v) {
+  if (i == FIELD_VBAT) {
+    // mV to hundredths of a volt, ties (mV ending in 5) as above
+    if (v < 0) *p++ = '-';
+    uint16_t mv = v < 0 ? -(int32_t)v : v;
+    uint16_t hundredths = mv % 10 == 5 ? floatHundredths(v * 0.001) : (mv + 5) / 10;
+    return putDecimal(p, hundredths, 2);
+  } else if (i == FIELD_SPEED || i == FIELD_ENG_TEMP || i == FIELD_IMU_TEMP) {
+    // Already tenths of a km/h / °C
+    if (v < 0) *p++ = '-';
+    return putDecimal(p, v < 0 ? -(int32_t)v : v, 1);
+  } else if (i < FIELD_IMU_FIRST + 3) {
+    return putScaled<25, 9>(p, v, IMU_ACCEL_SCALE);
+  } else if (i < FIELD_IMU_FIRST + 6) {
+    return putScaled<3125, 9>(p, v, IMU_GYRO_SCALE);
+  } else if (i < FIELD_IMU_FIRST + 9) {
+    return putScaled<1125, 11>(p, v, IMU_ANGLE_SCALE);
+  }
+  return putInt(p, v);
+}
+
+static void sendTelemetryTsv(const int16_t* fields, uint16_t mask, unsigned long tMs) {
+  char frame[TSV_FRAME_MAX];
+  char* p = frame;
+
+  // Fields not in the mask stay empty, tabs preserved
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    if (i > 0) *p++ = '\t';
+    if (mask & (1 << i)) p = putTsvField(p, i, fields[i]);
+  }
+
+  // Always present: sequence (shared with binary frames) and acquisition time
+  *p++ = '\t';
+  p = putUint(p, txSeq++);
+  *p++ = '\t';
+  p = putUint(p, tMs);
 
   // Null terminator (no newline)
-  Serial.write('\0');
+  *p++ = '\0';
+  tx.begin();
+  tx.write((const uint8_t*)frame, p - frame);
+  tx.commit();
+}
+
+static int16_t pickStat(int16_t last, int16_t mean, int16_t peak) {
+  if (frameStat == STAT_MEAN) return mean;
+  if (frameStat == STAT_PEAK) return peak;
+  return last;
+}
+
+// Swap in the between-frame statistic for the aggregated fields in `mask`
+// and restart their aggregates; lo/hi get the range. Returns the fields
+// that had samples.
+static uint16_t applyAggregates(int16_t* fields, uint16_t mask, int16_t* lo, int16_t* hi) {
+  uint16_t out = 0;
+
+  if (mask & (1 << FIELD_VBAT)) {
+    VoltageStats v;
+    voltage_take_stats(v);  // Always, so the window restarts from this frame
+    if (v.count > 0) {
+      int peak = (long)v.maxMv - v.meanMv >= (long)v.meanMv - v.minMv ? v.maxMv : v.minMv;
+      fields[FIELD_VBAT] = pickStat(fields[FIELD_VBAT], v.meanMv, peak);
+      lo[FIELD_VBAT] = v.minMv;
+      hi[FIELD_VBAT] = v.maxMv;
+      out |= 1 << FIELD_VBAT;
+    }
+  }
+
+  if ((mask & MASK_IMU) && imuAgg.count() > 0) {
+    for (uint8_t i = 0; i < 9; i++) {
+      uint8_t f = FIELD_IMU_FIRST + i;
+      lo[f] = imuAgg.min(i);
+      hi[f] = imuAgg.max(i);
+      if (frameStat != STAT_LAST) {
+        fields[f] = pickStat(fields[f], imuAgg.mean(i), imuAgg.peak(i));
+      }
+    }
+    imuAgg.reset();
+    out |= MASK_IMU;
+  }
+  return out;
+}
+
+// Delta mode: drop fields that moved less than their deadband since last sent
+// Returns the reduced mask; every field goes out at least once per keyframe
+static uint16_t applyDelta(const int16_t* fields, uint16_t mask) {
+  unsigned long now = millis();
+  if (now - lastKeyframe >= KEYFRAME_INTERVAL_MS) {
+    lastKeyframe = now;
+    keyframePending = 0xFFFF;  // Resync: send each field once, next time it is available
+  }
+
+  uint16_t out = 0;
+  for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+    uint16_t bit = 1 << i;
+    if (!(mask & bit)) continue;
+
+    // Angles: int16 difference, wraps correctly across ±180° (|-32768| taken
+    // as uint16). The rest: 32-bit, a full-scale swing is no wrap.
+    uint16_t diff;
+    if (MASK_ANGLES & bit) {
+      int16_t d = (int16_t)((uint16_t)fields[i] - (uint16_t)lastSent[i]);
+      diff = d < 0 ? -(uint16_t)d : (uint16_t)d;
+    } else {
+      int32_t d = (int32_t)fields[i] - lastSent[i];
+      diff = d < 0 ? -d : d;  // Up to 65535
+    }
+    if ((keyframePending & bit) || diff > (uint16_t)pgm_read_word(&DEADBAND[i])) {
+      out |= bit;
+      lastSent[i] = fields[i];
+    }
+  }
+  keyframePending &= ~out;
+  return out;
+}
+
+void comms_send_telemetry(int voltage_mv, const ImuRaw& imu, int rpm, int gear, int speed,
+                          uint8_t groups) {
+  int16_t fields[FIELD_COUNT];
+  fields[FIELD_VBAT] = voltage_mv;
+  fields[FIELD_RPM] = rpm;
+  fields[FIELD_GEAR] = gear;
+  fields[FIELD_SPEED] = speed;
+  comms_send_fields(fields, imu, groups & ~(TLM_ENG_TEMP | TLM_IMU_TEMP));
+}
+
+void comms_send_fields(int16_t* fields, const ImuRaw& imu, uint8_t groups) {
+  fields[FIELD_IMU_FIRST + 0] = imu.ax;
+  fields[FIELD_IMU_FIRST + 1] = imu.ay;
+  fields[FIELD_IMU_FIRST + 2] = imu.az;
+  fields[FIELD_IMU_FIRST + 3] = imu.gx;
+  fields[FIELD_IMU_FIRST + 4] = imu.gy;
+  fields[FIELD_IMU_FIRST + 5] = imu.gz;
+  fields[FIELD_IMU_FIRST + 6] = imu.roll;
+  fields[FIELD_IMU_FIRST + 7] = imu.pitch;
+  fields[FIELD_IMU_FIRST + 8] = imu.yaw;
+
+  // Absent groups are left out entirely (Pi keeps its last value)
+  uint16_t mask = fieldMask(groups);
+  if (format == FORMAT_BATCH && (mask & MASK_IMU)) {
+    // Queue each WT61 sample once (TIMED mode can offer the same one twice)
+    if (imu.lastUpdateUs != lastBatchedUs) {
+      lastBatchedUs = imu.lastUpdateUs;
+      if (imuBatch.push(imu, imu.lastUpdateUs)) sendImuBatch();
+    }
+    mask &= ~MASK_IMU;
+    imuAgg.reset();  // The batch carries every sample already
+    if (mask == 0) return;
+  }
+
+  int16_t lo[FIELD_AGG_COUNT], hi[FIELD_AGG_COUNT];
+  uint16_t rangeMask = applyAggregates(fields, mask, lo, hi);
+  if (rangeEnabled && format != FORMAT_TSV && rangeMask != 0) {
+    sendRange(lo, hi, rangeMask);  // Even if delta then skips the frame - extremes still count
+  }
+
+  if (deltaEnabled) {
+    mask = applyDelta(fields, mask);
+    if (mask == 0) return;  // Nothing moved - skip the frame
+  }
+
+  // Acquisition time: the WT61 sample when it's in the frame, else now
+  // (slow channels are read right before sending)
+  unsigned long tMs = (mask & MASK_IMU) ? imu.lastUpdate : millis();
+
+  if (format != FORMAT_TSV) {
+    sendTelemetryBinary(fields, mask, tMs);
+  } else {
+    sendTelemetryTsv(fields, mask, tMs);
+  }
+}
+
+void comms_set_delta(bool enabled) {
+  deltaEnabled = enabled;
+  keyframePending = 0xFFFF;  // Start from a full frame
+  lastKeyframe = millis();
+}
+
+bool comms_get_delta() {
+  return deltaEnabled;
+}
+
+void comms_set_stat(TelemetryStat stat) {
+  frameStat = stat;
+  imuAgg.reset();  // Aggregates start with the next sample
+}
+
+TelemetryStat comms_get_stat() {
+  return frameStat;
+}
+
+void comms_set_range(bool enabled) {
+  rangeEnabled = enabled;
+  imuAgg.reset();
+}
+
+bool comms_get_range() {
+  return rangeEnabled;
+}
+
+void comms_aggregate_imu(const ImuRaw& imu) {
+  if (frameStat == STAT_LAST && !rangeEnabled) return;  // Nothing reads it
+  int16_t v[9] = { imu.ax, imu.ay, imu.az, imu.gx, imu.gy, imu.gz, imu.roll, imu.pitch, imu.yaw };
+  imuAgg.add(v);
+}
+
+TelemetryMode comms_get_mode() {
+  return txMode;
+}
+
+void comms_set_format(TelemetryFormat f) {
+  format = f;
+  imuBatch.clear();  // Start a fresh batch (or drop a partial one)
+}
+
+TelemetryFormat comms_get_format() {
+  return format;
 }
 
 void comms_send(const char* key, float value, int decimals) {
-  Serial.print(key);
-  Serial.print(": ");
-  Serial.println(value, decimals);
+  tx.begin();
+  tx.print(key);
+  tx.print(": ");
+  tx.println(value, decimals);
+  tx.commit();
 }
 
 void comms_send(const char* key, int value) {
-  Serial.print(key);
-  Serial.print(": ");
-  Serial.println(value);
+  tx.begin();
+  tx.print(key);
+  tx.print(": ");
+  tx.println(value);
+  tx.commit();
 }
 
 void comms_send(const char* key, const char* value) {
-  Serial.print(key);
-  Serial.print(": ");
-  Serial.println(value);
+  tx.begin();
+  tx.print(key);
+  tx.print(": ");
+  tx.println(value);
+  tx.commit();
 }
 
-const char* comms_get_command() {
-  if (cmdReady) {
-    cmdReady = false;
-    return cmdBuf;
+bool comms_send_alert(uint8_t rule, bool active, int16_t value, unsigned long tMs) {
+  if (format != FORMAT_TSV) {
+    frameBegin(FRAME_ALERT, 8, 0);
+    frameWrite(rule);
+    frameWrite(active);
+    frameWriteI16(value);
+    frameWriteI16(tMs & 0xFFFF);
+    frameWriteI16(tMs >> 16);
+    return frameEnd();
   }
-  return "";
+
+  tx.begin(0);
+  tx.print(F("ALERT:"));
+  tx.print(reinterpret_cast<const __FlashStringHelper*>(alert_name((AlertRule)rule)));
+  tx.print(active ? F(":ON:v=") : F(":OFF:v="));
+  tx.print(value);
+  tx.print(F(":t="));
+  tx.print(tMs);
+  tx.println();
+  return tx.commit();
+}
+
+static void printPerfField(const __FlashStringHelper* key, long value) {
+  tx.print(key);
+  tx.print(value);
+}
+
+void comms_send_perf(const PerfStats& stats) {
+  // PERF:key=value:... - same k=v style as commands, one line
+  tx.begin();
+  printPerfField(F("PERF:loop_min="), stats.loopMinUs);
+  printPerfField(F(":loop_avg="), stats.loopAvgUs);
+  printPerfField(F(":loop_max="), stats.loopMaxUs);
+  printPerfField(F(":loops="), stats.loops);
+  printPerfField(F(":imu_ok="), stats.imuPackets);
+  printPerfField(F(":imu_bad="), stats.imuChecksumErrors);
+  printPerfField(F(":imu_resync="), stats.imuResyncs);
+  printPerfField(F(":imu_skip="), stats.imuDroppedBytes);
+  printPerfField(F(":rx_drop="), stats.rxOverflows);
+  printPerfField(F(":rpm_drop="), stats.rpmOverruns);
+  printPerfField(F(":free_ram="), stats.freeRam);
+  printPerfField(F(":tx_drop="), stats.txDrops);
+  printPerfField(F(":spd_drop="), stats.speedOverruns);
+  tx.println();
+  tx.commit();
+}
+
+uint16_t comms_rx_overflows() {
+  return rxOverflows;
+}
+
+uint16_t comms_tx_drops() {
+  return tx.drops;
+}
+
+uint16_t comms_tx_pending() {
+  return tx.pending();
 }
 
 bool comms_is_connected(unsigned long timeout_ms) {
@@ -3,27 +3,136 @@
 
 #include <Arduino.h>
 #include "imu.h"
+#include "perf.h"
+
+// Telemetry output format
+// TSV is the human-readable debug default, BINARY is the compact framed mode
+// (see PROTOCOL.md for the frame layout)
+enum TelemetryFormat : uint8_t {
+  FORMAT_TSV = 0,
+  FORMAT_BINARY = 1,
+  FORMAT_BATCH = 2,   // BINARY, with IMU samples sent IMU_BATCH_SIZE at a time
+};
+
+// Telemetry modes
+// TIMED: full frame every CH_TELEMETRY period, regardless of IMU cadence
+// EVENT: IMU frame the moment each WT61 angle packet lands (IMU_RATE_HZ), slow
+//        channels ride along on the next frame at their own rates
+enum TelemetryMode : uint8_t {
+  MODE_TIMED = 0,
+  MODE_EVENT = 1,
+};
+
+// Telemetry field groups for comms_send_telemetry()
+// Groups left out go as empty TSV fields / cleared binary mask bits,
+// and the Pi keeps the last value it had for them
+static const uint8_t TLM_VOLTAGE = 0x01;
+static const uint8_t TLM_IMU     = 0x02;
+static const uint8_t TLM_RPM     = 0x04;
+static const uint8_t TLM_GEAR    = 0x08;
+static const uint8_t TLM_SPEED   = 0x10;
+static const uint8_t TLM_ENG_TEMP = 0x20;
+static const uint8_t TLM_IMU_TEMP = 0x40;
+static const uint8_t TLM_ALL     = 0x7F;
+
+// Telemetry field indices (shared by TSV column order and binary field mask)
+static const uint8_t FIELD_VBAT = 0;
+static const uint8_t FIELD_IMU_FIRST = 1;   // Ax..Yaw occupy 1-9
+static const uint8_t FIELD_RPM = 10;
+static const uint8_t FIELD_GEAR = 11;
+static const uint8_t FIELD_SPEED = 12;
+static const uint8_t FIELD_ENG_TEMP = 13;
+static const uint8_t FIELD_IMU_TEMP = 14;
+static const uint8_t FIELD_COUNT = 15;
 
 // Initialize Pi serial communication (call in setup)
 void comms_init();
 
-// Process incoming commands from Pi - call in loop
-// Returns true if a complete command was received
+// Process incoming commands from Pi and drain queued output - call in loop
+// Complete CMD:NAME:key=value lines are dispatched straight away and answered
+// with ACK:NAME:OK|ERR|UNKNOWN[:key=value...] (see PROTOCOL.md). CMD:HELLO
+// moves the link to a faster baud rate, and this falls back to the boot rate
+// when the Pi doesn't follow.
+// Returns true if a command was handled
 bool comms_update();
 
-// Send complete telemetry frame (TSV format, null-terminated)
-// Format: V_bat\tAx\tAy\tAz\tGx\tGy\tGz\tRoll\tPitch\tYaw\tRPM\tGear\0
-// If imu_valid is false, IMU fields are empty (but tabs preserved)
-void comms_send_telemetry(float voltage, const ImuData& imu, bool imu_valid, int rpm, int gear);
+// Send telemetry frame in the current format, with the TLM_* groups in `groups`
+// TSV:    V_bat\tAx\tAy\tAz\tGx\tGy\tGz\tRoll\tPitch\tYaw\tRPM\tGear\tSpeed\tEng_T\tImu_T\tSeq\tT_ms\0
+//         Fields not sent are empty (but tabs preserved)
+// BINARY: Sync + header + field mask + t_ms + int16 fields + CRC16
+//         Fields not sent are left out of the mask
+// BATCH:  IMU group buffered, one burst frame per IMU_BATCH_SIZE samples;
+//         other groups go out as BINARY frames
+// Every frame carries a wrapping uint8 sequence number and the millis() the
+// data was acquired (the IMU sample's, if IMU fields are in the frame)
+// speed in 0.1 km/h (speed.h). No temperature arguments: those groups are
+// left out, whatever `groups` says
+void comms_send_telemetry(int voltage_mv, const ImuRaw& imu, int rpm, int gear, int speed,
+                          uint8_t groups);
+
+// Same, from a FIELD_COUNT array with the non-IMU fields already filled in
+// (sensors.h) - the IMU fields are taken from `imu`, the array is scratch
+void comms_send_fields(int16_t* fields, const ImuRaw& imu, uint8_t groups);
+
+// Select telemetry format (takes effect from the next frame)
+void comms_set_format(TelemetryFormat format);
+TelemetryFormat comms_get_format();
+
+// Delta frames: only send fields that moved beyond their deadband, plus a
+// full keyframe every second so the Pi resyncs (off by default)
+// Frames where nothing changed are skipped entirely
+void comms_set_delta(bool enabled);
+bool comms_get_delta();
+
+// What the IMU and voltage fields carry (CMD:AGG), over every sample since
+// the field was last sent - lower frame rates then keep the extremes
+// LAST: the latest sample (default)
+// MEAN: the mean
+// PEAK: whichever extreme (min or max) lies farther from the mean
+enum TelemetryStat : uint8_t {
+  STAT_LAST = 0,
+  STAT_MEAN = 1,
+  STAT_PEAK = 2,
+};
+void comms_set_stat(TelemetryStat stat);
+TelemetryStat comms_get_stat();
+
+// Range frames: min and max of the same samples, sent with each binary
+// telemetry frame (not in TSV) - off by default
+void comms_set_range(bool enabled);
+bool comms_get_range();
+
+// Fold a fresh IMU sample into the aggregate - call on each imu_update() hit
+// (voltage samples are folded in by voltage.cpp itself)
+void comms_aggregate_imu(const ImuRaw& imu);
+
+// Frame timing set by CMD:MODE (channel rates live in sched.h)
+TelemetryMode comms_get_mode();
+
+// Send an alert state change (alert.h) ahead of the telemetry schedule
+// TSV: ALERT:NAME:ON|OFF:v=<value>:t=<ms> text line, binary formats: an
+// alert frame (PROTOCOL.md). value is in the rule's units, t the crossing time.
+// Alerts may use TX queue room that frames and lines leave spare, so they
+// still get out with the link over budget. Returns false if not queued.
+bool comms_send_alert(uint8_t rule, bool active, int16_t value, unsigned long tMs);
 
 // Send key:value line (for debug/ACK, newline-terminated)
 void comms_send(const char* key, float value, int decimals = 2);
 void comms_send(const char* key, int value);
 void comms_send(const char* key, const char* value);
 
-// Get last received command (empty if none)
-// Command buffer is cleared after reading
-const char* comms_get_command();
+// Send perf counters as one text line (see PROTOCOL.md)
+void comms_send_perf(const PerfStats& stats);
+
+// Pi command bytes dropped because a line overflowed cmdBuf (running total)
+uint16_t comms_rx_overflows();
+
+// Output is queued and drained to Serial without blocking, from comms_update()
+// Frames/lines dropped because the queue was full (running total)
+uint16_t comms_tx_drops();
+
+// Bytes queued but not yet handed to Serial
+uint16_t comms_tx_pending();
 
 // Check if connected (received any data recently)
 bool comms_is_connected(unsigned long timeout_ms = 5000);
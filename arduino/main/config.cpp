@@ -0,0 +1,55 @@
+#include "config.h"
+#include "crc16.h"
+#include <EEPROM.h>
+
+// EEPROM layout: [magic] [version] [Config...] [crc16 lo] [crc16 hi] at address 0
+// CRC covers magic..Config, so a blank (0xFF) or half-written record is rejected
+static const int CONFIG_ADDR = 0;
+static const uint8_t CONFIG_MAGIC = 0x5E;   // "SErow"
+static const uint8_t CONFIG_VERSION = 5;  // 2: format, WT61 flag, IMU offsets, 3: SPEED channel, 4: alerts, 5: TEMP/ITEMP channels
+
+struct ConfigRecord {
+  uint8_t magic;
+  uint8_t version;
+  Config data;
+  uint16_t crc;
+};
+
+static Config config = {};
+static bool valid = false;
+
+static uint16_t recordCrc(const ConfigRecord& rec) {
+  const uint8_t* p = (const uint8_t*)&rec;
+  uint16_t crc = CRC16_INIT;
+  for (size_t i = 0; i < offsetof(ConfigRecord, crc); i++) {
+    crc = crc16_update(crc, p[i]);
+  }
+  return crc;
+}
+
+bool config_init() {
+  ConfigRecord rec;
+  EEPROM.get(CONFIG_ADDR, rec);
+  valid = rec.magic == CONFIG_MAGIC && rec.version == CONFIG_VERSION
+       && rec.crc == recordCrc(rec);
+  config = valid ? rec.data : Config();
+  return valid;
+}
+
+bool config_valid() {
+  return valid;
+}
+
+Config& config_get() {
+  return config;
+}
+
+void config_save() {
+  ConfigRecord rec = {};
+  rec.magic = CONFIG_MAGIC;
+  rec.version = CONFIG_VERSION;
+  rec.data = config;
+  rec.crc = recordCrc(rec);
+  EEPROM.put(CONFIG_ADDR, rec);  // put() uses update(): unchanged bytes aren't rewritten
+  valid = true;
+}
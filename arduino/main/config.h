@@ -0,0 +1,36 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+#include "sched.h"
+#include "alert.h"
+
+// Settings persisted in EEPROM across power cycles
+// Stored as one versioned, CRC-checked record; bump CONFIG_VERSION in
+// config.cpp whenever this layout changes (old records are then ignored)
+struct Config {
+  uint16_t periodMs[CH_RATE_COUNT];  // Scheduler channel periods (sched.cpp)
+  uint8_t format;                    // TelemetryFormat (comms.cpp)
+  uint8_t wt61RateCmd;               // WT61 rate command last applied, 0 = never (imu.cpp)
+  uint8_t imuCalibrated;             // imuOffsets hold a calibration run (imu.cpp)
+  int16_t imuOffsets[8];             // ax ay az gx gy gz roll pitch, raw counts
+  uint16_t alertAt[ALERT_RULES];     // Alert thresholds, rule units (alert.cpp)
+  uint16_t alertHyst[ALERT_RULES];
+};
+
+// Load the stored record (call first in setup)
+// Returns false if EEPROM is blank, corrupt or from another layout version;
+// modules then fall back to their own defaults
+bool config_init();
+
+// True if config_init() found a valid record
+bool config_valid();
+
+// Working copy - modules read their part at init (filling in their defaults
+// when there was no valid record) and update it on change
+Config& config_get();
+
+// Write the working copy back to EEPROM
+void config_save();
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <Arduino.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) - Python's binascii.crc_hqx
+// Shared by binary frames and the EEPROM config record
+static const uint16_t CRC16_INIT = 0xFFFF;
+
+static inline uint16_t crc16_update(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+#endif
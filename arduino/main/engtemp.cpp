@@ -0,0 +1,92 @@
+#include "engtemp.h"
+#include "adc.h"
+#include "ringbuf.h"
+
+static int _tenths = 0;
+static bool _valid = false;
+
+#if ENG_TEMP_NTC
+
+// NTC curve: ADC counts at TEMP_FIRST, TEMP_FIRST + TEMP_STEP, ... (descending,
+// the NTC's resistance drops as it warms). Edit for your sensor - this is a
+// 10k B3950 NTC with a 10k pull-up: counts = 1023 * R / (R + 10k)
+static const int16_t TEMP_FIRST = -20;  // °C
+static const int16_t TEMP_STEP = 10;    // °C
+static const uint16_t NTC_COUNTS[] PROGMEM = {
+  934, 873, 788, 684, 569, 456, 354, 270, 204,  // -20..60
+  153, 115, 87, 67, 51, 40, 31, 25, 20,         // 70..150
+};
+static const uint8_t NTC_POINTS = sizeof(NTC_COUNTS) / sizeof(NTC_COUNTS[0]);
+
+static const uint8_t PIN_ENG_TEMP = A2;
+static const uint16_t FAULT_OPEN = 1000;   // Counts: pulled up, no sensor
+static const uint16_t FAULT_SHORT = 8;     // Counts: sensor lead shorted to GND
+static const uint8_t FILTER_SHIFT = 2;     // EMA over ~4 readings (~1s)
+
+// ADC handler (ISR on the 328P): sum DECIMATION conversions into one reading
+// (~4Hz, x64 for sub-count resolution) and queue it for engtemp_update()
+static const uint8_t DECIMATION = 64;  // 64 * 1023 fits the uint16 sum
+static RingBuffer<uint16_t, 4> _readings;
+static uint16_t _decimSum = 0;
+static uint8_t _decimCount = 0;
+
+static void onAdcSample(uint16_t raw) {
+  _decimSum += raw;
+  if (++_decimCount < DECIMATION) return;
+
+  _readings.push(_decimSum);  // Full = loop stalled, newest dropped
+  _decimSum = 0;
+  _decimCount = 0;
+}
+
+// Interpolate a reading (counts x DECIMATION) on the curve, clamped to its ends
+static int toTenths(uint16_t sum) {
+  if (sum >= pgm_read_word(&NTC_COUNTS[0]) * DECIMATION) return TEMP_FIRST * 10;
+  for (uint8_t i = 1; i < NTC_POINTS; i++) {
+    uint16_t lo = pgm_read_word(&NTC_COUNTS[i]) * DECIMATION;
+    if (sum > lo) {
+      uint16_t hi = pgm_read_word(&NTC_COUNTS[i - 1]) * DECIMATION;
+      // Past point i-1 by (hi - sum) of the (hi - lo) between the two
+      return (TEMP_FIRST + (i - 1) * TEMP_STEP) * 10 +
+             (int)((uint32_t)(hi - sum) * (TEMP_STEP * 10) / (hi - lo));
+    }
+  }
+  return (TEMP_FIRST + (NTC_POINTS - 1) * TEMP_STEP) * 10;
+}
+
+void engtemp_init() {
+  _valid = false;
+  adc_attach(PIN_ENG_TEMP, onAdcSample);  // No analogRead() seed - the ADC is already running
+}
+
+void engtemp_update() {
+  uint16_t sum;
+  while (_readings.pop(sum)) {
+    if (sum > FAULT_OPEN * DECIMATION || sum < FAULT_SHORT * DECIMATION) {
+      _valid = false;  // Starts over from the next good reading
+      continue;
+    }
+    int t = toTenths(sum);
+    if (!_valid) {
+      _tenths = t;
+      _valid = true;
+    } else {
+      _tenths += (t - _tenths) >> FILTER_SHIFT;
+    }
+  }
+}
+
+#else
+
+void engtemp_init() {}
+void engtemp_update() {}
+
+#endif
+
+int engtemp_get() {
+  return _tenths;
+}
+
+bool engtemp_valid() {
+  return _valid;
+}
@@ -0,0 +1,19 @@
+#ifndef ENGTEMP_H
+#define ENGTEMP_H
+
+#include <Arduino.h>
+
+// Engine / coolant temperature from an NTC thermistor on A2 (to GND, with a
+// pull-up to 5V), sampled in the background by the shared ADC (adc.h) -
+// nothing waits on a conversion. Curve and pull-up are at the top of engtemp.cpp.
+// Build with ENG_TEMP_NTC=0 when no sensor is fitted (A2 would float).
+#ifndef ENG_TEMP_NTC
+#define ENG_TEMP_NTC 1
+#endif
+
+void engtemp_init();    // Call in setup, after voltage_init() (adc.h)
+void engtemp_update();  // Call in loop - converts the averaged readings
+int engtemp_get();      // 0.1 °C
+bool engtemp_valid();   // False before the first reading, or with the sensor open/shorted
+
+#endif
@@ -0,0 +1,141 @@
+#include "fusion.h"
+#include "imu.h"
+
+// Gyro LSB -> Q16 angle LSB per sample:
+// (2000/32768 deg/s) * (32768/180 LSB/deg) * (1/IMU_RATE_HZ s) * 65536
+static constexpr int32_t GYRO_STEP_Q16 = (int32_t)(2000.0 / 180.0 / IMU_RATE_HZ * 65536.0 + 0.5);
+
+static const uint16_t MAX_GAIN_Q15 = 16384;  // 0.5 - keeps err * gain * 2 in int32
+
+// Q16 angles held unsigned so wrapping through ±180° is defined behaviour
+static uint32_t rollQ16 = 0;
+static uint32_t pitchQ16 = 0;
+static bool seeded = false;
+static uint16_t gain = 655;
+
+// Mount rotation, Q15 (row-major 3x3)
+static int16_t mount[9] = {
+  32767, 0, 0,
+  0, 32767, 0,
+  0, 0, 32767,
+};
+
+uint16_t fusion_isqrt(uint32_t x) {
+  // Bit-by-bit, 16 iterations, no multiply or divide
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > x) bit >>= 2;
+  while (bit != 0) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+// atan(z) for z in [0, 1] (Q15), result in angle LSB (8192 = 45°)
+// atan(z) ~ pi/4 z + z(1 - z)(0.2447 + 0.0663 z), max error 0.0015 rad
+static int32_t atanUnit(uint16_t z) {
+  int32_t t = ((int32_t)z * (32768L - z)) >> 15;
+  int32_t u = 2552 + ((692L * z) >> 15);
+  return ((8192L * z) >> 15) + ((t * u) >> 15);
+}
+
+int16_t fusion_atan2(int32_t y, int32_t x) {
+  uint32_t ay = y < 0 ? -y : y;
+  uint32_t ax = x < 0 ? -x : x;
+  if (ax == 0 && ay == 0) return 0;
+
+  // Fold into the first octant, then unfold
+  int32_t a;
+  if (ax >= ay) {
+    a = atanUnit((uint16_t)((ay << 15) / ax));
+  } else {
+    a = 16384 - atanUnit((uint16_t)((ax << 15) / ay));
+  }
+  if (x < 0) a = 32768 - a;
+  if (y < 0) a = -a;
+  return (int16_t)a;  // +32768 wraps to -32768, both are 180°
+}
+
+void fusion_reset() {
+  seeded = false;
+}
+
+void fusion_set_gain(uint16_t gainQ15) {
+  gain = gainQ15 > MAX_GAIN_Q15 ? MAX_GAIN_Q15 : gainQ15;
+}
+
+uint16_t fusion_get_gain() {
+  return gain;
+}
+
+// Pull a Q16 angle towards a measured one by gain (int16 error wraps at ±180°)
+static void correct(uint32_t& angleQ16, int16_t measured) {
+  int16_t err = measured - (int16_t)(angleQ16 >> 16);
+  angleQ16 += (uint32_t)((int32_t)err * gain * 2);  // Q15 * 2 -> Q16
+}
+
+void fusion_update(const int16_t acc[3], const int16_t gyro[3]) {
+  // Gravity direction: roll about X, pitch about Y
+  uint32_t yy = (int32_t)acc[1] * acc[1];
+  uint32_t zz = (int32_t)acc[2] * acc[2];
+  int32_t ayz = fusion_isqrt(yy + zz);
+  int16_t accRoll = fusion_atan2(acc[1], acc[2]);
+  int16_t accPitch = fusion_atan2(-(int32_t)acc[0], ayz);
+
+  if (!seeded) {
+    rollQ16 = (uint32_t)(int32_t)accRoll << 16;
+    pitchQ16 = (uint32_t)(int32_t)accPitch << 16;
+    seeded = true;
+    return;
+  }
+
+  rollQ16 += (uint32_t)((int32_t)gyro[0] * GYRO_STEP_Q16);
+  pitchQ16 += (uint32_t)((int32_t)gyro[1] * GYRO_STEP_Q16);
+  correct(rollQ16, accRoll);
+  correct(pitchQ16, accPitch);
+}
+
+int16_t fusion_roll() {
+  return (int16_t)(rollQ16 >> 16);
+}
+
+int16_t fusion_pitch() {
+  return (int16_t)(pitchQ16 >> 16);
+}
+
+static int16_t toQ15(float v) {
+  long q = lround(v * 32768.0);
+  return q > 32767 ? 32767 : (q < -32767 ? -32767 : q);
+}
+
+void fusion_set_mount(int16_t ax, int16_t ay, int16_t az) {
+  // Sensor tilt from gravity: a = (-sin p, sin r cos p, cos r cos p)
+  // M = Ry(p) * Rx(r) takes it back onto (0, 0, |a|) - gravity kept, not zeroed
+  float r = atan2((float)ay, (float)az);
+  float p = atan2(-(float)ax, sqrt((float)ay * ay + (float)az * az));
+  float sr = sin(r), cr = cos(r), sp = sin(p), cp = cos(p);
+
+  int16_t m[9] = {
+    toQ15(cp),  toQ15(sp * sr), toQ15(sp * cr),
+    0,          toQ15(cr),      toQ15(-sr),
+    toQ15(-sp), toQ15(cp * sr), toQ15(cp * cr),
+  };
+  memcpy(mount, m, sizeof(mount));
+  seeded = false;  // Frame changed - reseed from the next sample
+}
+
+void fusion_mount(int16_t v[3]) {
+  // Rows are unit vectors, so |sum| <= |v| * 32767 - fits int32
+  int32_t x = v[0], y = v[1], z = v[2];
+  for (uint8_t i = 0; i < 3; i++) {
+    const int16_t* row = &mount[i * 3];
+    int32_t sum = (int32_t)row[0] * x + (int32_t)row[1] * y + (int32_t)row[2] * z;
+    v[i] = (int16_t)(sum >> 15);
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <Arduino.h>
+
+// Fixed-point complementary filter for roll/pitch from raw WT61 accel + gyro
+// Everything per update is integer: angles in WT61 angle LSB (32768 = 180°),
+// state in Q16 of that, gain in Q15. No float, one isqrt, two integer atan2.
+//
+// angle += gyro * dt                    (integrate, short-term accurate)
+// angle += gain * (accel_angle - angle)  (pull towards gravity, long-term)
+
+// Reset the filter - it seeds itself from the next accel sample
+void fusion_reset();
+
+// Accel correction gain, Q15 (clamped to 0.5) - default 655 (0.02)
+// Time constant = sample period / gain: ~2.5s at 20Hz, 0.5s at 100Hz
+void fusion_set_gain(uint16_t gainQ15);
+uint16_t fusion_get_gain();
+
+// One filter step per WT61 sample (nominal period 1 / IMU_RATE_HZ)
+// acc/gyro are raw counts in the bike frame (see fusion_mount())
+void fusion_update(const int16_t acc[3], const int16_t gyro[3]);
+
+// Filtered angles, WT61 angle LSB
+int16_t fusion_roll();
+int16_t fusion_pitch();
+
+// Mount calibration that keeps gravity: from the mean accel vector at rest,
+// build the rotation that takes it onto +Z (float, once per calibration)
+// Identity until set
+void fusion_set_mount(int16_t ax, int16_t ay, int16_t az);
+
+// Rotate a raw sensor vector into the bike frame (Q15 matrix, in place)
+void fusion_mount(int16_t v[3]);
+
+// atan2 in WT61 angle LSB (±32768 = ±180°), ~0.1° max error
+// |x|, |y| up to 65535 (sensor counts, or the isqrt of a sum of squares)
+int16_t fusion_atan2(int32_t y, int32_t x);
+
+// Integer square root (floor)
+uint16_t fusion_isqrt(uint32_t x);
+
+#endif
@@ -1,19 +1,219 @@
 #include "gear.h"
+#include "adc.h"
+#include "ringbuf.h"
+
+// Band lookup: ascending edges (PROGMEM) split the input into n + 1 bands,
+// band i covering edges[i-1] <= v < edges[i]. Binary search, 3 steps for 6 gears.
+static uint8_t findBand(const uint16_t* edges, uint8_t n, uint16_t v) {
+  uint8_t lo = 0, hi = n;
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) >> 1;
+    if (v < pgm_read_word(&edges[mid])) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+// Hysteresis + debounce: stay in the current band until v is `hyst` past one
+// of its edges, then take the new band once `debounce` readings agree on it
+struct BandTracker {
+  uint8_t band;
+  uint8_t candidate;
+  uint8_t count;
+};
+
+static void trackBand(BandTracker& t, const uint16_t* edges, uint8_t n, uint16_t v,
+                      uint16_t hyst, uint8_t debounce) {
+  uint16_t lo = t.band > 0 ? pgm_read_word(&edges[t.band - 1]) : 0;
+  bool aboveLo = lo <= hyst || v >= lo - hyst;
+  bool belowHi = t.band >= n || v < pgm_read_word(&edges[t.band]) + hyst;
+  if (aboveLo && belowHi) {
+    t.count = 0;
+    return;
+  }
+
+  uint8_t band = findBand(edges, n, v);
+  if (band != t.candidate) {
+    t.candidate = band;
+    t.count = 0;
+  }
+  if (++t.count >= debounce) {
+    t.band = band;
+    t.count = 0;
+  }
+}
+
+static BandTracker _tracker = {};
+static int _gear = 0;
+
+#if GEAR_SOURCE == 1
+
+// Gear position sensor: a resistor ladder on the gear drum, one nominal output
+// per position. Edit for your bike: measure A1 in each position (ignition on)
+// and list them in ascending voltage order - the band edges fall halfway
+// between neighbours and are computed at compile time.
+// Example: 5-speed, 1-N-2-3-4-5 drum order on a 5V ladder
+static constexpr uint16_t SENSOR_MV[] = { 700, 1400, 2100, 2800, 3500, 4200 };
+static const int8_t SENSOR_GEAR[] PROGMEM = { 1, 0, 2, 3, 4, 5 };
+static const uint8_t SENSOR_POSITIONS = sizeof(SENSOR_MV) / sizeof(SENSOR_MV[0]);
+
+static const uint8_t PIN_GEAR = A1;
+static const uint16_t HYSTERESIS = 10;     // ADC counts, ~50mV
+static const uint8_t DEBOUNCE = 4;         // Readings, ~65ms - neutral flashes by on 1-2 shifts
+static const uint16_t FAULT_MARGIN_MV = 300;  // Beyond the end positions: open/shorted sensor
+
+static constexpr uint16_t mvToCounts(uint16_t mv) {
+  return (uint32_t)mv * 1023 / 5000;
+}
+static constexpr uint16_t sensorEdge(uint8_t i) {
+  return mvToCounts((SENSOR_MV[i] + SENSOR_MV[i + 1]) / 2);
+}
+static constexpr bool ascending(uint8_t i) {
+  return i + 1 >= SENSOR_POSITIONS || (SENSOR_MV[i] < SENSOR_MV[i + 1] && ascending(i + 1));
+}
+
+static const uint16_t SENSOR_EDGES[] PROGMEM = {
+  sensorEdge(0), sensorEdge(1), sensorEdge(2), sensorEdge(3), sensorEdge(4),
+};
+static const uint16_t FAULT_LOW = mvToCounts(SENSOR_MV[0] - FAULT_MARGIN_MV);
+static const uint16_t FAULT_HIGH = mvToCounts(SENSOR_MV[SENSOR_POSITIONS - 1] + FAULT_MARGIN_MV);
+
+static_assert(ascending(0), "SENSOR_MV must be in ascending order");
+static_assert(sizeof(SENSOR_GEAR) == SENSOR_POSITIONS, "one gear per sensor position");
+static_assert(sizeof(SENSOR_EDGES) / sizeof(SENSOR_EDGES[0]) == SENSOR_POSITIONS - 1,
+              "one edge between each pair of positions");
+static_assert(SENSOR_MV[0] > FAULT_MARGIN_MV, "lowest position too close to 0V");
+
+// ADC handler (ISR on the 328P): average DECIMATION conversions into one
+// reading (~61Hz) and queue it for gear_update()
+static const uint8_t DECIMATION = 4;
+static RingBuffer<uint16_t, 8> _readings;
+static uint16_t _decimSum = 0;
+static uint8_t _decimCount = 0;
+
+static void onAdcSample(uint16_t raw) {
+  _decimSum += raw;
+  if (++_decimCount < DECIMATION) return;
+
+  _readings.push(_decimSum / DECIMATION);  // Full = loop stalled, newest dropped
+  _decimSum = 0;
+  _decimCount = 0;
+}
+
+static bool _haveReading = false;
+
+void gear_init() {
+  _tracker = {};
+  _haveReading = false;
+  _gear = 0;
+  adc_attach(PIN_GEAR, onAdcSample);  // No analogRead() seed - the ADC is already running
+}
+
+void gear_update(int rpm, int speed) {
+  uint16_t raw;
+  while (_readings.pop(raw)) {
+    if (raw < FAULT_LOW || raw > FAULT_HIGH) continue;  // Hold the last gear
+    if (!_haveReading) {
+      // First reading: take it as is, nothing to debounce against
+      _tracker.band = _tracker.candidate = findBand(SENSOR_EDGES, SENSOR_POSITIONS - 1, raw);
+      _haveReading = true;
+    }
+    trackBand(_tracker, SENSOR_EDGES, SENSOR_POSITIONS - 1, raw, HYSTERESIS, DEBOUNCE);
+  }
+  if (_haveReading) _gear = (int8_t)pgm_read_byte(&SENSOR_GEAR[_tracker.band]);
+}
+
+#elif GEAR_SOURCE == 2
+
+// Ratio estimate: in gear, engine RPM per km/h is fixed by the gearbox,
+// final drive and wheel size. Edit for your bike: hold a steady speed in each
+// gear and note RPM / km/h, listed in ascending order (top gear first) - x10
+// for resolution. Band edges fall halfway between neighbours, at compile time.
+// Example: 5-speed trail bike
+static constexpr uint16_t RATIO_X10[] = { 420, 500, 630, 850, 1300 };
+static const int8_t RATIO_GEAR[] PROGMEM = { 5, 4, 3, 2, 1 };
+static const uint8_t RATIO_GEARS = sizeof(RATIO_X10) / sizeof(RATIO_X10[0]);
+
+static const uint16_t MIN_SPEED = 50;        // 0.1 km/h - slower reads as stopped
+static const uint16_t MIN_RPM = 1200;        // Below: idling, clutch in
+static const uint8_t FAULT_MARGIN_PCT = 15;  // Beyond the end gears: clutch slipping / wheelspin
+static const uint16_t HYSTERESIS = 10;       // Ratio x10, ~2% at the top gears
+static const uint8_t DEBOUNCE = 5;           // Readings, 100ms - skips the ratio swing mid-shift
+static const unsigned long INTERVAL_MS = 20;
+
+static constexpr uint16_t ratioEdge(uint8_t i) {
+  return (RATIO_X10[i] + RATIO_X10[i + 1]) / 2;
+}
+static constexpr bool ascending(uint8_t i) {
+  return i + 1 >= RATIO_GEARS || (RATIO_X10[i] < RATIO_X10[i + 1] && ascending(i + 1));
+}
+
+static const uint16_t RATIO_EDGES[] PROGMEM = {
+  ratioEdge(0), ratioEdge(1), ratioEdge(2), ratioEdge(3),
+};
+static const uint16_t RATIO_LOW = (uint32_t)RATIO_X10[0] * (100 - FAULT_MARGIN_PCT) / 100;
+static const uint16_t RATIO_HIGH = (uint32_t)RATIO_X10[RATIO_GEARS - 1] * (100 + FAULT_MARGIN_PCT) / 100;
+
+static_assert(ascending(0), "RATIO_X10 must be in ascending order");
+static_assert(sizeof(RATIO_GEAR) == RATIO_GEARS, "one gear per ratio");
+static_assert(sizeof(RATIO_EDGES) / sizeof(RATIO_EDGES[0]) == RATIO_GEARS - 1,
+              "one edge between each pair of ratios");
+
+static bool _haveRatio = false;
+static unsigned long _lastRatio = 0;
+
+void gear_init() {
+  _tracker = {};
+  _haveRatio = false;
+  _gear = 0;
+}
+
+void gear_update(int rpm, int speed) {
+  // RPM and speed update per pulse - sample at a fixed rate so DEBOUNCE is time
+  unsigned long now = millis();
+  if (now - _lastRatio < INTERVAL_MS) return;
+  _lastRatio = now;
+
+  if (speed < (int)MIN_SPEED) {
+    _haveRatio = false;  // Stopped: start over once rolling
+    _gear = 0;
+    return;
+  }
+  if (rpm < (int)MIN_RPM) return;  // Clutch in / coasting: hold the last gear
+
+  uint16_t ratio = (uint32_t)rpm * 100 / speed;
+  if (ratio < RATIO_LOW || ratio > RATIO_HIGH) return;  // Hold the last gear
+  if (!_haveRatio) {
+    _tracker.band = _tracker.candidate = findBand(RATIO_EDGES, RATIO_GEARS - 1, ratio);
+    _haveRatio = true;
+  }
+  trackBand(_tracker, RATIO_EDGES, RATIO_GEARS - 1, ratio, HYSTERESIS, DEBOUNCE);
+  _gear = (int8_t)pgm_read_byte(&RATIO_GEAR[_tracker.band]);
+}
+
+#else
 
 // Mock gear: derived from RPM bands
-// Real sensor would read position switch
+// N < 1000, 1st < 2500, 2nd < 4000, 3rd < 5500, 4th < 7000, 5th+
+static const uint16_t MOCK_RPM_EDGES[] PROGMEM = { 1000, 2500, 4000, 5500, 7000 };
+static const uint8_t MOCK_BANDS = sizeof(MOCK_RPM_EDGES) / sizeof(MOCK_RPM_EDGES[0]);
+static const uint16_t MOCK_HYSTERESIS = 150;  // RPM
 
 void gear_init() {
-  // Nothing to init for mock
-}
-
-int gear_get(int rpm) {
-  // Simulate gear based on RPM
-  // N < 1000, 1st < 2500, 2nd < 4000, 3rd < 5500, 4th < 7000, 5th+
-  if (rpm < 1000) return 0;  // Neutral
-  if (rpm < 2500) return 1;
-  if (rpm < 4000) return 2;
-  if (rpm < 5500) return 3;
-  if (rpm < 7000) return 4;
-  return 5;
+  _tracker = {};
+  _gear = 0;
+}
+
+void gear_update(int rpm, int speed) {
+  trackBand(_tracker, MOCK_RPM_EDGES, MOCK_BANDS, rpm < 0 ? 0 : rpm, MOCK_HYSTERESIS, 1);
+  _gear = _tracker.band;  // Band i = gear i
+}
+
+#endif
+
+int gear_get() {
+  return _gear;
 }
@@ -1,7 +1,25 @@
 #ifndef GEAR_H
 #define GEAR_H
 
+#include <Arduino.h>
+
+// Gear source (build option, override with -DGEAR_SOURCE=n)
+// 0: mock - RPM bands, for the bench without a sensor
+// 1: analog gear position sensor on A1 (one voltage per position, see gear.cpp)
+// 2: estimated from the RPM / wheel speed ratio (speed.h, ratios in gear.cpp)
+//    0 while stopped (no ratio to go by), clutch in holds the last gear
+#ifndef GEAR_SOURCE
+#define GEAR_SOURCE 0
+#endif
+
 void gear_init();
-int gear_get(int rpm);  // Returns gear 0-6 (0=neutral)
+
+// Track the gear - call in loop with the latest rpm and speed (0.1 km/h),
+// used by the mock and the ratio estimate
+// Band edges have hysteresis and a new gear has to hold for a few readings,
+// so the value doesn't flicker at an edge or on the way through neutral
+void gear_update(int rpm, int speed);
+
+int gear_get();  // Returns gear 0-6 (0=neutral)
 
 #endif
@@ -1,9 +1,20 @@
 #include "imu.h"
+#include "fusion.h"
+#include "config.h"
+
+// IMU serial port - IMU_HW_UART build option, see imu.h
+#if IMU_HW_UART
+static auto& imuSerial = Serial1;
+static const long IMU_BAUD = 115200;
+static const long IMU_ALT_BAUD = 9600;     // Where a WT61 set up for the 328P build sits
+static const uint8_t IMU_RATE_CMD = 0x63;  // 115200 bauds / 100Hz report
+#else
 #include <AltSoftSerial.h>
-
-// AltSoftSerial uses fixed pins on ATmega328P:
-// RX = Pin 8, TX = Pin 9
 static AltSoftSerial imuSerial;
+static const long IMU_BAUD = 9600;
+static const long IMU_ALT_BAUD = 115200;   // WT61 factory default
+static const uint8_t IMU_RATE_CMD = 0x64;  // 9600 bauds / 20Hz report
+#endif
 
 // WT61 packet structure:
 // Byte 0: 0x55 (header)
@@ -14,26 +25,51 @@ static const uint8_t PACKET_HEADER = 0x55;
 static const uint8_t PACKET_ACCEL  = 0x51;
 static const uint8_t PACKET_GYRO   = 0x52;
 static const uint8_t PACKET_ANGLE  = 0x53;
-static const int PACKET_SIZE = 11;
+static const uint8_t PACKET_SIZE = 11;
 
 // Receive buffer
 static uint8_t rxBuf[PACKET_SIZE];
-static int rxIndex = 0;
+static uint8_t rxIndex = 0;
+
+// Parser counters
+static ImuStats stats = {};
 
-// Latest data
-static ImuData currentData = {0};
+// Latest data: raw as received, and with calibration offsets applied
+static ImuRaw currentData = {};
+static int16_t tempRaw = 0;  // Die temperature, bytes 8-9 of every packet
+static ImuRaw calibratedData = {};
 
-// Calibration offsets and state
-static ImuData offsets = {0};
+// Calibration offsets (raw counts) and state
+static ImuRaw offsets = {};
 static bool calibrated = false;
 
-// Scale factors from WT61 datasheet
-// Accel: raw / 32768 * 16g
-// Gyro:  raw / 32768 * 2000 deg/s
-// Angle: raw / 32768 * 180 deg
-static const float ACCEL_SCALE = 16.0 / 32768.0;
-static const float GYRO_SCALE  = 2000.0 / 32768.0;
-static const float ANGLE_SCALE = 180.0 / 32768.0;
+// Onboard roll/pitch fusion (off = WT61's own Kalman angles)
+static bool fusionEnabled = false;
+
+// Background calibration: accumulates angle packets from processPacket(),
+// sums are relative to the first sample so an angle sitting on the ±180°
+// seam doesn't average out to zero
+static const unsigned long WARMUP_MS = 500;  // WT61 sends junk right after power-on
+static unsigned long initTime = 0;
+
+// Boot trusted the stored WT61 config: reconfigure if nothing parses by then
+// (module swapped or reset to factory settings)
+static const unsigned long VERIFY_MS = 1500;
+static bool verifyConfig = false;
+static struct {
+  uint8_t target;  // 0 = idle
+  uint8_t count;
+  ImuRaw first;
+  long sum_ax, sum_ay, sum_az;
+  long sum_gx, sum_gy, sum_gz;
+  long sum_roll, sum_pitch, sum_yaw;
+} cal = {};
+
+// Offset subtraction stays in int16: wrapping is exactly right for angles
+// (±32768 = ±180°), and accel/gyro never get near full scale on a bike
+static inline int16_t applyOffset(int16_t value, int16_t offset) {
+  return (int16_t)(value - offset);
+}
 
 static int16_t parseI16(uint8_t lo, uint8_t hi) {
   return (int16_t)((hi << 8) | lo);
@@ -41,167 +77,304 @@ static int16_t parseI16(uint8_t lo, uint8_t hi) {
 
 static bool validateChecksum() {
   uint8_t sum = 0;
-  for (int i = 0; i < PACKET_SIZE - 1; i++) {
+  for (uint8_t i = 0; i < PACKET_SIZE - 1; i++) {
     sum += rxBuf[i];
   }
   return sum == rxBuf[PACKET_SIZE - 1];
 }
 
-static void processPacket() {
-  if (!validateChecksum()) {
-    return;  // Bad packet, ignore
+// Calibration survives power cycles in the config record, except yaw: the
+// WT61 restarts its heading at 0 on power-up, so an old yaw offset is stale
+static void loadCalibration() {
+  const Config& cfg = config_get();
+  if (!config_valid() || !cfg.imuCalibrated) return;
+
+  offsets = {};
+  offsets.ax = cfg.imuOffsets[0];
+  offsets.ay = cfg.imuOffsets[1];
+  offsets.az = cfg.imuOffsets[2];
+  offsets.gx = cfg.imuOffsets[3];
+  offsets.gy = cfg.imuOffsets[4];
+  offsets.gz = cfg.imuOffsets[5];
+  offsets.roll = cfg.imuOffsets[6];
+  offsets.pitch = cfg.imuOffsets[7];
+  fusion_set_mount(offsets.ax, offsets.ay, offsets.az);
+  calibrated = true;
+}
+
+// EEPROM writes block ~3.4ms per changed byte (up to ~60ms here) - only at the
+// end of a run. The 20Hz AltSoftSerial stream rides it out in its RX buffer,
+// at 100Hz (IMU_HW_UART) a few packets can be lost.
+static void saveCalibration() {
+  Config& cfg = config_get();
+  cfg.imuOffsets[0] = offsets.ax;
+  cfg.imuOffsets[1] = offsets.ay;
+  cfg.imuOffsets[2] = offsets.az;
+  cfg.imuOffsets[3] = offsets.gx;
+  cfg.imuOffsets[4] = offsets.gy;
+  cfg.imuOffsets[5] = offsets.gz;
+  cfg.imuOffsets[6] = offsets.roll;
+  cfg.imuOffsets[7] = offsets.pitch;
+  cfg.imuCalibrated = 1;
+  config_save();
+}
+
+// Called on every complete angle packet (end of a WT61 accel/gyro/angle burst)
+static void calibrationStep() {
+  if (cal.target == 0) return;
+  if (millis() - initTime < WARMUP_MS) return;
+
+  const ImuRaw& d = currentData;
+  if (cal.count == 0) cal.first = d;
+  cal.sum_ax += (int16_t)(d.ax - cal.first.ax);
+  cal.sum_ay += (int16_t)(d.ay - cal.first.ay);
+  cal.sum_az += (int16_t)(d.az - cal.first.az);
+  cal.sum_gx += (int16_t)(d.gx - cal.first.gx);
+  cal.sum_gy += (int16_t)(d.gy - cal.first.gy);
+  cal.sum_gz += (int16_t)(d.gz - cal.first.gz);
+  cal.sum_roll += (int16_t)(d.roll - cal.first.roll);
+  cal.sum_pitch += (int16_t)(d.pitch - cal.first.pitch);
+  cal.sum_yaw += (int16_t)(d.yaw - cal.first.yaw);
+
+  if (++cal.count < cal.target) return;
+
+  // Done - swap in the averaged offsets in one go, so every packet after this
+  // one sees a consistent set (never half old, half new)
+  const uint8_t n = cal.target;
+  ImuRaw next = {};
+  next.ax = cal.first.ax + cal.sum_ax / n;
+  next.ay = cal.first.ay + cal.sum_ay / n;
+  next.az = cal.first.az + cal.sum_az / n;
+  next.gx = cal.first.gx + cal.sum_gx / n;
+  next.gy = cal.first.gy + cal.sum_gy / n;
+  next.gz = cal.first.gz + cal.sum_gz / n;
+  next.roll = cal.first.roll + cal.sum_roll / n;
+  next.pitch = cal.first.pitch + cal.sum_pitch / n;
+  next.yaw = cal.first.yaw + cal.sum_yaw / n;
+  offsets = next;
+
+  // Fusion keeps gravity: the mean accel sets the mount rotation instead
+  fusion_set_mount(next.ax, next.ay, next.az);
+
+  calibrated = true;
+  cal.target = 0;
+  saveCalibration();
+}
+
+// WitMotion packet types live in 0x50-0x5F - anything else after a 0x55
+// means we synced on a 0x55 that was really payload
+static inline bool isPacketType(uint8_t b) {
+  return (b & 0xF0) == 0x50;
+}
+
+// False sync: drop the bogus header and slide the buffer to the next 0x55
+// already received, instead of throwing away all the bytes after it
+static void resync() {
+  stats.resyncs++;
+  uint8_t k = 1;
+  while (k < rxIndex && rxBuf[k] != PACKET_HEADER) k++;
+  stats.droppedBytes += k;
+  memmove(rxBuf, rxBuf + k, rxIndex - k);
+  rxIndex -= k;
+}
+
+// Resync until the buffer starts with a plausible header + type (or is empty)
+static void settleSync() {
+  while (rxIndex >= 2 && !isPacketType(rxBuf[1])) {
+    resync();
   }
+}
+
+// Fusion path, once per burst: gyro bias off, rotate accel/gyro into the bike
+// frame (gravity kept), then filter roll/pitch. Yaw stays the WT61's.
+static void applyFusion() {
+  int16_t acc[3] = { currentData.ax, currentData.ay, currentData.az };
+  int16_t gyro[3] = {
+    applyOffset(currentData.gx, offsets.gx),
+    applyOffset(currentData.gy, offsets.gy),
+    applyOffset(currentData.gz, offsets.gz),
+  };
+  fusion_mount(acc);
+  fusion_mount(gyro);
+  fusion_update(acc, gyro);
+
+  calibratedData.ax = acc[0];
+  calibratedData.ay = acc[1];
+  calibratedData.az = acc[2];
+  calibratedData.gx = gyro[0];
+  calibratedData.gy = gyro[1];
+  calibratedData.gz = gyro[2];
+  calibratedData.roll = fusion_roll();
+  calibratedData.pitch = fusion_pitch();
+}
+
+// Returns true if this was a valid angle packet (completes a sample)
+// Checksum already verified by imu_update()
+static bool processPacket() {
+  stats.packets++;
 
   uint8_t type = rxBuf[1];
   int16_t v0 = parseI16(rxBuf[2], rxBuf[3]);
   int16_t v1 = parseI16(rxBuf[4], rxBuf[5]);
   int16_t v2 = parseI16(rxBuf[6], rxBuf[7]);
-  // v3 at bytes 8-9 is temperature, ignored for now
+  tempRaw = parseI16(rxBuf[8], rxBuf[9]);  // Same in all three packet types
 
   switch (type) {
     case PACKET_ACCEL:
-      currentData.ax = v0 * ACCEL_SCALE;
-      currentData.ay = v1 * ACCEL_SCALE;
-      currentData.az = v2 * ACCEL_SCALE;
+      currentData.ax = v0;
+      currentData.ay = v1;
+      currentData.az = v2;
+      if (fusionEnabled) break;  // Filled in by applyFusion() with the angles
+      calibratedData.ax = applyOffset(v0, offsets.ax);
+      calibratedData.ay = applyOffset(v1, offsets.ay);
+      calibratedData.az = applyOffset(v2, offsets.az);
       break;
     case PACKET_GYRO:
-      currentData.gx = v0 * GYRO_SCALE;
-      currentData.gy = v1 * GYRO_SCALE;
-      currentData.gz = v2 * GYRO_SCALE;
+      currentData.gx = v0;
+      currentData.gy = v1;
+      currentData.gz = v2;
+      if (fusionEnabled) break;
+      calibratedData.gx = applyOffset(v0, offsets.gx);
+      calibratedData.gy = applyOffset(v1, offsets.gy);
+      calibratedData.gz = applyOffset(v2, offsets.gz);
       break;
     case PACKET_ANGLE:
-      currentData.roll  = v0 * ANGLE_SCALE;
-      currentData.pitch = v1 * ANGLE_SCALE;
-      currentData.yaw   = v2 * ANGLE_SCALE;
+      currentData.roll  = v0;
+      currentData.pitch = v1;
+      currentData.yaw   = v2;
       currentData.lastUpdate = millis();
-      break;
+      currentData.lastUpdateUs = micros();
+      calibratedData.roll  = applyOffset(v0, offsets.roll);
+      calibratedData.pitch = applyOffset(v1, offsets.pitch);
+      calibratedData.yaw   = applyOffset(v2, offsets.yaw);
+      calibratedData.lastUpdate = currentData.lastUpdate;
+      calibratedData.lastUpdateUs = currentData.lastUpdateUs;
+      if (fusionEnabled) applyFusion();
+      calibrationStep();
+      return true;
   }
+  return false;
 }
 
-void imu_init() {
-  // Configure WT61 at 115200 - stays there (no baud switch)
-  // See IMU.md for command reference
-  imuSerial.begin(115200);
-
-  imu_send_cmd(0x52);  // Reset yaw (for the sake of it)
+static void sendConfig() {
+  imu_send_cmd(0x52);          // Reset yaw (for the sake of it)
   delay(50);
-  imu_send_cmd(0x65);  // Flat mounting mode
+  imu_send_cmd(0x65);          // Flat mounting mode
   delay(50);
-  imu_send_cmd(0x64);  // 9600 bauds / 20Hz report
-  delay(50);          // Let WT61 process config
+  imu_send_cmd(IMU_RATE_CMD);  // Our baud / report rate
+  delay(50);                   // Let WT61 process config
+}
 
-  // Revert to 9600 bauds
-  imuSerial.begin(9600);
+// WT61 ignores commands at the wrong baud (IMU.md), so configure at the
+// other rate first in case it is still there, then again at ours (~300ms)
+// See IMU.md for command reference
+static void configure() {
+  imuSerial.begin(IMU_ALT_BAUD);
+  sendConfig();
 
-  // In case WT61 already is at 9600
-  imu_send_cmd(0x52);  // Reset yaw (for the sake of it)
-  delay(50);
-  imu_send_cmd(0x65);  // Flat mounting mode
-  delay(50);
-  imu_send_cmd(0x64);  // 9600 bauds / 20Hz report
-  delay(50);          // Let WT61 process config
+  imuSerial.begin(IMU_BAUD);
+  sendConfig();
 
+  Config& cfg = config_get();
+  if (cfg.wt61RateCmd != IMU_RATE_CMD) {
+    cfg.wt61RateCmd = IMU_RATE_CMD;
+    config_save();
+  }
+}
+
+void imu_init() {
+  // The WT61 keeps its settings in flash: skip configuring it once the stored
+  // record says this build's rate was applied (imu_update() checks it talks)
+  if (config_valid() && config_get().wt61RateCmd == IMU_RATE_CMD) {
+    imuSerial.begin(IMU_BAUD);
+    verifyConfig = true;
+  } else {
+    configure();
+  }
 
   rxIndex = 0;
-  currentData = {0};
+  currentData = {};
+  calibratedData = {};
+  loadCalibration();
+  initTime = millis();
 }
 
 bool imu_update() {
-  bool gotPacket = false;
+  bool gotSample = false;
 
   while (imuSerial.available()) {
     uint8_t c = imuSerial.read();
 
     // State machine: look for header, then collect packet
-    if (rxIndex == 0) {
-      if (c == PACKET_HEADER) {
-        rxBuf[rxIndex++] = c;
-      }
-      // else: discard, wait for sync
-    } else {
-      rxBuf[rxIndex++] = c;
+    if (rxIndex == 0 && c != PACKET_HEADER) {
+      stats.droppedBytes++;
+      continue;  // Discard, wait for sync
+    }
+    rxBuf[rxIndex++] = c;
 
-      if (rxIndex >= PACKET_SIZE) {
-        processPacket();
+    if (rxIndex == 2) {
+      settleSync();  // Catch false syncs at the type byte, not 9 bytes later
+    } else if (rxIndex >= PACKET_SIZE) {
+      if (validateChecksum()) {
+        if (processPacket()) gotSample = true;
         rxIndex = 0;
-        gotPacket = true;
+      } else {
+        // Bad packet - rescan what we have for the real header
+        stats.checksumErrors++;
+        resync();
+        settleSync();
       }
     }
   }
 
-  return gotPacket;
-}
-
-const ImuData& imu_get_data() {
-  // Apply calibration offsets if calibrated
-  // Using a static to avoid creating new struct each call
-  static ImuData calibratedData;
-
-  if (calibrated) {
-    calibratedData.ax = currentData.ax - offsets.ax;
-    calibratedData.ay = currentData.ay - offsets.ay;
-    calibratedData.az = currentData.az - offsets.az;
-    calibratedData.gx = currentData.gx - offsets.gx;
-    calibratedData.gy = currentData.gy - offsets.gy;
-    calibratedData.gz = currentData.gz - offsets.gz;
-    calibratedData.roll = currentData.roll - offsets.roll;
-    calibratedData.pitch = currentData.pitch - offsets.pitch;
-    calibratedData.yaw = currentData.yaw - offsets.yaw;
-    calibratedData.lastUpdate = currentData.lastUpdate;
-    return calibratedData;
+  if (verifyConfig && (stats.packets != 0 || millis() - initTime > VERIFY_MS)) {
+    verifyConfig = false;
+    if (stats.packets == 0) configure();  // Blocks once, ~300ms
   }
 
-  return currentData;
+  return gotSample;
 }
 
-bool imu_is_fresh(unsigned long timeout_ms) {
-  return (millis() - currentData.lastUpdate) < timeout_ms;
+const ImuRaw& imu_get_data() {
+  // Offsets are applied per packet in processPacket() (all zero until calibrated)
+  return calibratedData;
 }
 
-void imu_calibrate() {
-  const int SAMPLES = 5;  // ~250ms at 20Hz IMU rate
-
-  // Accumulators for averaging
-  float sum_ax = 0, sum_ay = 0, sum_az = 0;
-  float sum_gx = 0, sum_gy = 0, sum_gz = 0;
-  float sum_roll = 0, sum_pitch = 0, sum_yaw = 0;
+const ImuRaw& imu_get_raw() {
+  return currentData;
+}
 
-  int count = 0;
-  unsigned long lastUpdate = currentData.lastUpdate;
+ImuStats imu_get_stats() {
+  return stats;
+}
 
-  // Block until we've collected enough samples
-  while (count < SAMPLES) {
-    imu_update();
+int imu_temp() {
+  // raw / 340 + 36.25 °C (IMU.md) in tenths = (raw + 12325) / 34, rounded
+  // (floor division, so it stays right below 0 °C)
+  int32_t n = (int32_t)tempRaw + 12325 + 17;
+  return (int)((n < 0 ? n - 33 : n) / 34);
+}
 
-    if (currentData.lastUpdate != lastUpdate) {
-      // New angle packet arrived (lastUpdate only changes on angle packets)
-      sum_ax += currentData.ax;
-      sum_ay += currentData.ay;
-      sum_az += currentData.az;
-      sum_gx += currentData.gx;
-      sum_gy += currentData.gy;
-      sum_gz += currentData.gz;
-      sum_roll += currentData.roll;
-      sum_pitch += currentData.pitch;
-      sum_yaw += currentData.yaw;
+bool imu_is_fresh(unsigned long timeout_ms) {
+  return (millis() - currentData.lastUpdate) < timeout_ms;
+}
 
-      lastUpdate = currentData.lastUpdate;
-      count++;
-    }
-  }
+void imu_calibrate_start(uint8_t samples) {
+  if (samples == 0) samples = 1;
+  cal.target = samples;
+  cal.count = 0;
+  cal.first = {};
+  cal.sum_ax = cal.sum_ay = cal.sum_az = 0;
+  cal.sum_gx = cal.sum_gy = cal.sum_gz = 0;
+  cal.sum_roll = cal.sum_pitch = cal.sum_yaw = 0;
+}
 
-  // Store averaged offsets
-  offsets.ax = sum_ax / SAMPLES;
-  offsets.ay = sum_ay / SAMPLES;
-  offsets.az = sum_az / SAMPLES;
-  offsets.gx = sum_gx / SAMPLES;
-  offsets.gy = sum_gy / SAMPLES;
-  offsets.gz = sum_gz / SAMPLES;
-  offsets.roll = sum_roll / SAMPLES;
-  offsets.pitch = sum_pitch / SAMPLES;
-  offsets.yaw = sum_yaw / SAMPLES;
+bool imu_is_calibrating() {
+  return cal.target != 0;
+}
 
-  calibrated = true;
+uint8_t imu_calibration_progress() {
+  return cal.count;
 }
 
 bool imu_is_calibrated() {
@@ -213,3 +386,18 @@ void imu_send_cmd(uint8_t cmd) {
   imuSerial.write(packet, 3);
   imuSerial.flush();
 }
+
+void imu_zero_yaw() {
+  // WT61 resets its heading to 0 - a calibrated yaw offset would now skew it
+  imu_send_cmd(0x52);
+  offsets.yaw = 0;
+}
+
+void imu_set_fusion(bool enabled) {
+  if (enabled && !fusionEnabled) fusion_reset();
+  fusionEnabled = enabled;
+}
+
+bool imu_get_fusion() {
+  return fusionEnabled;
+}
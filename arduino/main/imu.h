@@ -3,46 +3,109 @@
 
 #include <Arduino.h>
 
-// WT61 IMU data structure
-struct ImuData {
-  // Acceleration (g)
-  float ax, ay, az;
-  // Angular velocity (deg/s)
-  float gx, gy, gz;
-  // Euler angles (degrees)
-  float roll, pitch, yaw;
-  // Timestamp of last valid packet (millis)
+// IMU serial port (build option, override with -DIMU_HW_UART=0/1)
+// 1: board with a spare hardware UART - WT61 at 115200 / 100Hz
+//    Nano Every: Serial1 on D0(RX)/D1(TX), the Pi then talks over USB (Serial)
+// 0: AltSoftSerial (ATmega328P fixed pins RX = 8, TX = 9) - WT61 at 9600 / 20Hz,
+//    AltSoftSerial can't sustain RX at 115200
+#ifndef IMU_HW_UART
+#if defined(ARDUINO_AVR_NANO_EVERY)
+#define IMU_HW_UART 1
+#else
+#define IMU_HW_UART 0
+#endif
+#endif
+
+#if IMU_HW_UART
+static const uint8_t IMU_RATE_HZ = 100;
+#else
+static const uint8_t IMU_RATE_HZ = 20;
+#endif
+
+// WT61 IMU data structure - raw sensor counts as sent by the module
+// No float math on the AVR: multiply by the IMU_*_SCALE constants below
+// only where engineering units are needed (TSV output, or on the Pi)
+struct ImuRaw {
+  // Acceleration (LSB, × IMU_ACCEL_SCALE → g)
+  int16_t ax, ay, az;
+  // Angular velocity (LSB, × IMU_GYRO_SCALE → deg/s)
+  int16_t gx, gy, gz;
+  // Euler angles (LSB, × IMU_ANGLE_SCALE → degrees, wraps at ±180)
+  int16_t roll, pitch, yaw;
+  // Timestamp of last valid angle packet (millis, and micros for batching)
   unsigned long lastUpdate;
+  unsigned long lastUpdateUs;
+};
+
+// Scale factors from WT61 datasheet (full scale / 32768)
+constexpr float IMU_ACCEL_SCALE = 16.0 / 32768.0;    // g per LSB
+constexpr float IMU_GYRO_SCALE  = 2000.0 / 32768.0;  // deg/s per LSB
+constexpr float IMU_ANGLE_SCALE = 180.0 / 32768.0;   // deg per LSB
+
+// Parser counters (running totals, wrap at 65535)
+struct ImuStats {
+  uint16_t packets;         // Valid packets of any type
+  uint16_t checksumErrors;  // Full packets that failed the checksum
+  uint16_t resyncs;         // False syncs recovered by rescanning the buffer
+  uint16_t droppedBytes;    // Bytes discarded while hunting for a header
 };
 
-// Initialize IMU serial (call in setup)
+// Initialize IMU serial (call in setup, after config_init())
+// Only configures the WT61 if the config record says it isn't yet
 void imu_init();
 
 // Process incoming bytes - call frequently in loop
-// Returns true if new complete packet was parsed
+// Returns true if a complete angle packet was parsed - the last packet of each
+// WT61 accel/gyro/angle burst, i.e. a fresh full sample is ready
 bool imu_update();
 
-// Get latest IMU data
-const ImuData& imu_get_data();
+// Get latest IMU data (raw counts, calibration offsets applied)
+const ImuRaw& imu_get_data();
+
+// Same, as the WT61 sent it: no offsets, no fusion - the accel keeps gravity
+// whether or not calibration took it out of imu_get_data()
+const ImuRaw& imu_get_raw();
+
+// Get parser counters
+ImuStats imu_get_stats();
+
+// WT61 die temperature from the latest packet, 0.1 °C - tracks the enclosure,
+// not the air (only meaningful while imu_is_fresh())
+int imu_temp();
 
 // Check if IMU data is fresh (updated within timeout_ms)
 bool imu_is_fresh(unsigned long timeout_ms = 200);
 
-// Calibrate IMU - blocks for ~250ms while sampling
+// Start calibration in the background - non-blocking
+// Averages the next `samples` angle packets as imu_update() parses them
+// (skipping the WT61 power-on warm-up), then swaps in the new offsets at once
 // Sets current orientation as zero reference
-// Note: Zeroes all axes including accel (loses gravity reference)
-//       Revisit once mounting orientation is finalized
-void imu_calibrate();
+// WT61 angles: zeroes all axes including accel (loses gravity reference)
+// Fusion on: removes gyro bias and sets the mount rotation from the mean accel,
+//            so level reads roll/pitch 0 with accel still showing 1g on Z
+// The result is saved to EEPROM (config.h) and restored by imu_init()
+void imu_calibrate_start(uint8_t samples = IMU_RATE_HZ);  // ~1s of samples
 
-// Check if calibration has been performed
+// Check if a calibration run is in progress
+bool imu_is_calibrating();
+
+// Samples collected so far in the current calibration run
+uint8_t imu_calibration_progress();
+
+// Check if calibration has been performed (this boot, or restored from EEPROM)
 bool imu_is_calibrated();
 
 // Send command to IMU (see IMU.md for command list)
 // Common commands: 0x52 = zero yaw, 0x67 = calibrate accel
 void imu_send_cmd(uint8_t cmd);
 
-// Convenience: zero the yaw angle
-inline void imu_zero_yaw() { imu_send_cmd(0x52); }
+// Onboard roll/pitch fusion (fusion.h) from the raw accel + gyro, instead of
+// the WT61's own angles - off by default
+void imu_set_fusion(bool enabled);
+bool imu_get_fusion();
+
+// Zero the yaw angle (WT61 command 0x52), dropping any calibrated yaw offset
+void imu_zero_yaw();
 
 // Convenience: calibrate accelerometer (keep module level!)
 inline void imu_calibrate_accel() { imu_send_cmd(0x67); }
@@ -0,0 +1,67 @@
+#ifndef IMUBATCH_H
+#define IMUBATCH_H
+
+#include <Arduino.h>
+#include "imu.h"
+#include "ringbuf.h"
+
+// One batched IMU sample: time since the previous sample plus raw WT61 counts
+struct ImuBatchSample {
+  uint16_t dtUs;  // us since the previous sample (0 for the oldest, saturates at 65535)
+  int16_t v[9];   // ax ay az gx gy gz roll pitch yaw
+};
+
+// Ring of the last N IMU samples, flushed by comms as one binary burst
+// N is fixed at compile time: a power of two, and a full ring must fit one
+// frame payload (count + t0 + samples <= 255 bytes) and the SRAM budget.
+// When nobody drains it, the oldest sample is overwritten.
+template <uint8_t N>
+class ImuBatch {
+  static_assert(1 + 4 + N * sizeof(ImuBatchSample) <= 255, "ImuBatch must fit one frame payload");
+
+ public:
+  static const uint8_t CAPACITY = N;
+
+  // Add a sample taken at stampUs (micros()); returns true once the ring is full
+  bool push(const ImuRaw& d, unsigned long stampUs) {
+    if (samples_.full()) {
+      // Full: drop the oldest, the next one becomes the time base
+      samples_.drop(1);
+      firstUs_ += samples_[0].dtUs;
+      samples_[0].dtUs = 0;
+    }
+
+    ImuBatchSample& s = samples_.slot(0);
+    if (samples_.empty()) {
+      firstUs_ = stampUs;
+      s.dtUs = 0;
+    } else {
+      unsigned long dt = stampUs - lastUs_;
+      s.dtUs = dt > 0xFFFF ? 0xFFFF : dt;
+    }
+    lastUs_ = stampUs;
+
+    s.v[0] = d.ax; s.v[1] = d.ay; s.v[2] = d.az;
+    s.v[3] = d.gx; s.v[4] = d.gy; s.v[5] = d.gz;
+    s.v[6] = d.roll; s.v[7] = d.pitch; s.v[8] = d.yaw;
+    samples_.publish(1);
+    return samples_.full();
+  }
+
+  uint8_t count() const { return samples_.count(); }
+
+  // micros() of the oldest sample
+  unsigned long firstUs() const { return firstUs_; }
+
+  // i = 0 is the oldest
+  const ImuBatchSample& operator[](uint8_t i) const { return samples_[i]; }
+
+  void clear() { samples_.clear(); }
+
+ private:
+  RingBuffer<ImuBatchSample, N> samples_;  // Power of two, SRAM-checked there
+  unsigned long firstUs_ = 0;
+  unsigned long lastUs_ = 0;
+};
+
+#endif
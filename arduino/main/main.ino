@@ -1,83 +1,154 @@
 // Smart Serow - Main
 // Motorcycle telemetry hub
 
-#include "voltage.h"
+#include "sensors.h"
 #include "imu.h"
-#include "rpm.h"
-#include "gear.h"
+#include "adc.h"
+#include "alert.h"
 #include "comms.h"
+#include "perf.h"
+#include "power.h"
+#include "config.h"
+#include "sched.h"
 
-// Timing
-static const unsigned long TELEMETRY_INTERVAL_MS = 100;  // 10Hz telemetry
-static unsigned long lastTelemetryTime = 0;
+// Frame state - periods come from the scheduler channels (sched.h), slow
+// groups due wait in sensors_due() for the next frame
+static bool imuFrameDue = true;  // CH_IMU decimation (EVENT mode)
 
 void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
 
+  bool configLoaded = config_init();  // Before the modules that read it
   comms_init();    // Hardware Serial first so we can debug
   Serial.println(F("[INIT] comms ok"));
 
-  voltage_init();
-  Serial.println(F("[INIT] voltage ok"));
-
-  imu_init();      // AltSoftSerial on pins 8(RX)/9(TX)
+  if (configLoaded) {
+    Serial.println(F("[INIT] config loaded"));
+  } else {
+    Serial.println(F("[INIT] config defaults"));
+  }
+  sched_init();
+  alert_init();
+  sched_attach(CH_TELEMETRY, telemetryTask);
+  sched_attach(CH_IMU, imuTask);
+  Sensors::attach();  // VBAT, RPM, SPEED, GEAR, TEMP, ITEMP
+  sched_attach(CH_STATS, statsTask);
+  sched_attach(CH_HEARTBEAT, heartbeatTask);
+
+  Sensors::init();  // Voltage first: seeds with analogRead() before the ADC runs
+  Serial.println(F("[INIT] voltage/rpm/speed/gear/temp ok"));
+
+  imu_init();      // AltSoftSerial on pins 8(RX)/9(TX), or Serial1 (IMU_HW_UART)
   Serial.println(F("[INIT] imu ok"));
 
-  rpm_init();
-  gear_init();
-  Serial.println(F("[INIT] rpm/gear ok"));
+  // Stored calibration applies straight away; recalibrate with CMD:CALIBRATE
+  // First boot: zero calibration - current position becomes reference
+  // Runs in the background from imu_update() (skips the WT61 warm-up itself),
+  // so telemetry starts right away with uncalibrated data
+  if (imu_is_calibrated()) {
+    Serial.println(F("[INIT] calibration loaded, entering loop"));
+  } else {
+    imu_calibrate_start();
+    Serial.println(F("[INIT] calibrating in background, entering loop"));
+  }
+}
+
+void loop() {
+  perf_loop_begin();
+
+  // Always poll IMU - it's streaming at IMU_RATE_HZ
+  bool imuSample = imu_update();
+  if (imuSample) {
+    alert_check_imu(imu_get_data(), imu_get_raw());
+    comms_aggregate_imu(imu_get_data());  // Every sample, for CMD:AGG between frames
+  }
+  reportCalibration();
+
+  // Drain tach / wheel pulse timestamps, then the gear from both (sensors.h)
+  Sensors::update();
+  adc_update();
+  alert_update();  // Thresholds on the fresh voltage/RPM, events go out now
 
-  // Let IMU warm up a bit before calibrating
-  // (WT61 needs a moment to stabilize after power-on)
-  delay(500);
+  // Process any commands from Pi (dispatched and ACKed inside comms)
+  comms_update();
 
-  Serial.println(F("[INIT] calibrating..."));
-  // Zero calibration - current position becomes reference
-  // Blocks for ~250ms while sampling
-  imu_calibrate();
-  Serial.println(F("[INIT] calibration done, entering loop"));
+  unsigned long now = millis();
+  sched_run(now);
+  if (imuSample) onImuSample(now);
+
+  perf_loop_end();
+  power_update();  // Sleep until the next interrupt (power.h)
 }
 
-void loop() {
-  // Always poll IMU - it's streaming at 20Hz
-  imu_update();
-
-  // Update mock RPM (ramping)
-  rpm_update();
-
-  // Process any commands from Pi
-  if (comms_update()) {
-    const char* cmd = comms_get_command();
-    // Future: handle commands like "PING", "SET_RATE", etc.
-    // For now, echo back as acknowledgment
-    if (cmd[0] != '\0') {
-      comms_send("ACK", cmd);
+void reportCalibration() {
+  // Progress every few samples, then DONE once offsets are swapped in
+  static bool wasCalibrating = false;
+  static uint8_t lastReported = 0;
+
+  if (imu_is_calibrating()) {
+    uint8_t progress = imu_calibration_progress();
+    if (progress != lastReported && progress % 5 == 0) {
+      comms_send("CAL", (int)progress);
     }
+    lastReported = progress;
+    wasCalibrating = true;
+  } else if (wasCalibrating) {
+    comms_send("CAL", "DONE");
+    wasCalibrating = false;
+    lastReported = 0;
   }
+}
 
-  // Send telemetry at fixed interval
-  unsigned long now = millis();
-  if (now - lastTelemetryTime >= TELEMETRY_INTERVAL_MS) {
-    lastTelemetryTime = now;
-    sendTelemetry();
+void sendPerf() {
+  PerfStats stats;
+  perf_get(stats);
+  comms_send_perf(stats);
+}
+
+// Scheduler tasks
+// Slow channels flag their group as due (Sensors::attach()), it rides along
+// on the next frame
+void imuTask(unsigned long now) { imuFrameDue = true; }
+void statsTask(unsigned long now) { sendPerf(); }
+
+void heartbeatTask(unsigned long now) {
+  // Quick blink if IMU fresh, slow blink if stale
+  digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+  sched_set_period(CH_HEARTBEAT, imu_is_fresh() ? 500 : 2000);
+}
+
+void telemetryTask(unsigned long now) {
+  if (comms_get_mode() == MODE_TIMED) {
+    // Full frame at a fixed interval
+    sendFrame(TLM_ALL);
+  } else if (sensors_due() != 0 && !imu_is_fresh()) {
+    // EVENT with the IMU silent - don't hold the slow channels hostage
+    sendFrame(sensors_due());
   }
+}
 
-  // Heartbeat - quick blink if IMU fresh, slow blink if stale
-  static unsigned long lastBlink = 0;
-  unsigned long blinkInterval = imu_is_fresh() ? 500 : 2000;
-  if (now - lastBlink >= blinkInterval) {
-    lastBlink = now;
-    digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+void onImuSample(unsigned long now) {
+  if (comms_get_mode() != MODE_EVENT) return;
+
+  // Fresh IMU sample - send now, with whatever slow fields are due
+  // CH_IMU period 0 = every packet, otherwise at most one frame per period
+  if (sched_get_period(CH_IMU) != 0) {
+    if (!imuFrameDue) return;
+    imuFrameDue = false;
   }
+  sendFrame(TLM_IMU | sensors_due());
+}
+
+void sendFrame(uint8_t fields) {
+  sendTelemetry(fields);
+  sensors_clear_due();
 }
 
-void sendTelemetry() {
-  // Send all telemetry in a single TSV frame
-  float voltage = voltage_read();
-  const ImuData& imu = imu_get_data();
-  bool imu_valid = imu_is_fresh();
-  int rpm = rpm_get();
-  int gear = gear_get(rpm);
+void sendTelemetry(uint8_t fields) {
+  // Send requested field groups in a single frame
+  int16_t values[FIELD_COUNT];
+  fields &= Sensors::read(values) | TLM_IMU;
+  if (!imu_is_fresh()) fields &= ~TLM_IMU;
 
-  comms_send_telemetry(voltage, imu, imu_valid, rpm, gear);
+  comms_send_fields(values, imu_get_data(), fields);
 }
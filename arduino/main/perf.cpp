@@ -0,0 +1,65 @@
+#include "perf.h"
+#include "imu.h"
+#include "rpm.h"
+#include "speed.h"
+#include "comms.h"
+
+// Loop timing window
+static unsigned long loopStart = 0;
+static uint16_t loopMin = 0xFFFF;
+static uint16_t loopMax = 0;
+static unsigned long loopSum = 0;
+static uint16_t loopCount = 0;
+
+void perf_loop_begin() {
+  loopStart = micros();
+}
+
+void perf_loop_end() {
+  unsigned long elapsed = micros() - loopStart;
+  uint16_t us = elapsed > 0xFFFF ? 0xFFFF : elapsed;
+
+  if (us < loopMin) loopMin = us;
+  if (us > loopMax) loopMax = us;
+  if (loopCount < 0xFFFF) {
+    loopSum += us;
+    loopCount++;
+  }
+}
+
+static int freeRam() {
+#if defined(__AVR__)
+  // Gap between top of heap (or end of .bss if no malloc yet) and the stack
+  extern char __heap_start;
+  extern char* __brkval;
+  char top;
+  return &top - (__brkval ? __brkval : &__heap_start);
+#else
+  return -1;
+#endif
+}
+
+void perf_get(PerfStats& stats, bool reset) {
+  stats.loopMinUs = loopCount ? loopMin : 0;
+  stats.loopMaxUs = loopMax;
+  stats.loopAvgUs = loopCount ? loopSum / loopCount : 0;
+  stats.loops = loopCount;
+
+  ImuStats imu = imu_get_stats();
+  stats.imuPackets = imu.packets;
+  stats.imuChecksumErrors = imu.checksumErrors;
+  stats.imuResyncs = imu.resyncs;
+  stats.imuDroppedBytes = imu.droppedBytes;
+  stats.rxOverflows = comms_rx_overflows();
+  stats.rpmOverruns = rpm_overruns();
+  stats.speedOverruns = speed_overruns();
+  stats.txDrops = comms_tx_drops();
+  stats.freeRam = freeRam();
+
+  if (reset) {
+    loopMin = 0xFFFF;
+    loopMax = 0;
+    loopSum = 0;
+    loopCount = 0;
+  }
+}
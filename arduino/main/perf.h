@@ -0,0 +1,33 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <Arduino.h>
+
+// Hot-path counters for field tuning (reported via CMD:PERF)
+// Loop timings cover the window since the last perf_get(reset = true)
+struct PerfStats {
+  // loop() execution time (us)
+  uint16_t loopMinUs, loopAvgUs, loopMaxUs;
+  uint16_t loops;
+  // WT61 parser (running totals)
+  uint16_t imuPackets, imuChecksumErrors, imuResyncs, imuDroppedBytes;
+  // Pi command bytes dropped on cmdBuf overflow (running total)
+  uint16_t rxOverflows;
+  // Tach pulses dropped on a full edge buffer (running total)
+  uint16_t rpmOverruns;
+  // Wheel pulses dropped on a full edge buffer (running total)
+  uint16_t speedOverruns;
+  // Frames dropped on a full TX queue (running total)
+  uint16_t txDrops;
+  // Bytes between heap and stack (-1 if unknown)
+  int freeRam;
+};
+
+// Bracket loop() with these
+void perf_loop_begin();
+void perf_loop_end();
+
+// Collect counters from all modules, optionally starting a new timing window
+void perf_get(PerfStats& stats, bool reset = true);
+
+#endif
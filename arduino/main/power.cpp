@@ -0,0 +1,106 @@
+#include "power.h"
+#include "comms.h"
+#include "imu.h"
+#include "rpm.h"
+#include "speed.h"
+#include "voltage.h"
+
+#if POWER_SLEEP
+#include <avr/sleep.h>
+
+static const uint8_t WT61_SLEEP = 0x60;  // Toggles standby / active (IMU.md)
+static const unsigned long WAKE_CHECK_MS = 1000;
+
+static unsigned long parkedSince = 0;
+static bool parked = false;
+static unsigned long wokeAt = 0;
+static bool checkImu = false;  // WT61 should be streaming again since wokeAt
+
+// Wake only - the pin change itself is all that's needed
+ISR(PCINT2_vect) {}
+
+static bool isParked() {
+  int mv = voltage_read_mv();
+  return !comms_is_connected() && rpm_get() == 0 && speed_get() == 0 &&
+         mv < POWER_OFF_MV && mv > POWER_MIN_MV;
+}
+
+static void idle() {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  noInterrupts();
+  // A byte that landed after comms_update() ran gets handled now, not next tick
+  if (!Serial.available()) {
+    sleep_enable();
+    interrupts();  // The instruction after sei always runs: no wake-up is missed
+    sleep_cpu();
+    sleep_disable();
+  }
+  interrupts();
+}
+
+static void powerDown() {
+  comms_send("POWER", "SLEEP");
+  while (comms_tx_pending() > 0) comms_update();
+  if (comms_is_connected()) return;  // The Pi spoke up while we drained
+  Serial.flush();
+  imu_send_cmd(WT61_SLEEP);
+
+  // The ADC draws power while enabled, and its Timer0 trigger stops anyway
+  uint8_t adcsra = ADCSRA;
+  ADCSRA = 0;
+
+  // Any edge on D0 (Pi RX), D2 (tach), D3 (wheel) - the INT0/INT1 edge
+  // interrupts need the I/O clock, pin changes don't
+  PCMSK2 = _BV(PCINT16) | _BV(PCINT18) | _BV(PCINT19);
+  PCIFR = _BV(PCIF2);
+  PCICR |= _BV(PCIE2);
+
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  noInterrupts();
+  sleep_enable();
+  sleep_bod_disable();
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+
+  PCICR &= ~_BV(PCIE2);
+  PCMSK2 = 0;
+  ADCSRA = adcsra;
+
+  // millis() stood still while down; the byte that woke us is lost (the USART
+  // was off), the Pi's next command gets through
+  imu_send_cmd(WT61_SLEEP);
+  wokeAt = millis();
+  checkImu = true;
+  comms_send("POWER", "WAKE");
+}
+
+void power_update() {
+  unsigned long now = millis();
+
+  // The WT61 lost power too and came back active - the wake toggle sent it
+  // to standby, toggle once more
+  if (checkImu && now - wokeAt >= WAKE_CHECK_MS) {
+    checkImu = false;
+    if (!imu_is_fresh()) imu_send_cmd(WT61_SLEEP);
+  }
+
+  if (!isParked()) {
+    parked = false;
+  } else if (!parked) {
+    parked = true;
+    parkedSince = now;
+  } else if (now - parkedSince >= POWER_DOWN_AFTER_MS) {
+    powerDown();
+    parked = false;
+    return;
+  }
+
+  idle();
+}
+
+#else
+
+void power_update() {}
+
+#endif
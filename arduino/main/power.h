@@ -0,0 +1,33 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// Sleep between loop iterations instead of spinning on the serial ports
+// 1: ATmega328P idle sleep between events, power-down once parked (below)
+// 0: busy loop, as on other boards
+#ifndef POWER_SLEEP
+#if defined(__AVR_ATmega328P__)
+#define POWER_SLEEP 1
+#else
+#define POWER_SLEEP 0
+#endif
+#endif
+
+// Power-down once everything says the bike is parked, for POWER_DOWN_AFTER_MS:
+// no Pi commands (comms_is_connected - the Pi's 2s heartbeat PING keeps that
+// true while it runs), no tach or wheel pulses, and V_bat below
+// POWER_OFF_MV (resting battery - the charging system runs above it). Not
+// below POWER_MIN_MV: no battery on the divider, a USB-powered bench board.
+static const int POWER_OFF_MV = 12900;
+static const int POWER_MIN_MV = 6000;
+static const unsigned long POWER_DOWN_AFTER_MS = 60000;
+
+// Call at the end of loop(), after perf_loop_end()
+// Idles the CPU until the next interrupt (serial RX/TX, millis() tick, ADC,
+// tach / wheel pulse): at most ~1ms, so nothing is polled late. Once parked,
+// sends the WT61 to standby and powers down until a byte from the Pi or a
+// tach / wheel pulse, then wakes the WT61 and carries on.
+void power_update();
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef PULSE_H
+#define PULSE_H
+
+#include <Arduino.h>
+#include "ringbuf.h"
+
+// Pulse period filter shared by the tach (rpm.cpp) and wheel (speed.cpp) inputs
+//
+// The edge ISR only stamps micros() into a ring (edge()); the loop drains it
+// with next(), which drops edges closer than MinPeriodUs to the last real one
+// (ringing / contact bounce) and runs each period through median-of-3 then an
+// EMA of alpha = 1 / 2^EmaShift. The median kills single missed or extra
+// pulses, the EMA smooths the rest.
+template <uint8_t EdgeSlots, unsigned long MinPeriodUs, uint8_t EmaShift>
+class PulseFilter {
+ public:
+  // ISR side: timestamp an edge
+  void edge() {
+    if (!edges.push(micros())) {
+      overrunCount++;  // Loop stalled - drop, filter recovers on next edges
+    }
+  }
+
+  // Loop side
+
+  // Empties the edge ring and the filter (call before attaching the ISR)
+  void init() {
+    reset();
+    edges.clear();
+  }
+
+  // Forget the filter history, e.g. once pulses stopped
+  void reset() {
+    haveEdge = false;
+    periodIndex = 0;
+    periodCount = 0;
+    periodEma = 0;
+  }
+
+  // Next accepted period (raw, us) off the ring; false when it is drained.
+  // ema() already includes it.
+  bool next(unsigned long& period) {
+    unsigned long t;
+    while (edges.pop(t)) {
+      if (!haveEdge) {
+        lastEdge = t;
+        haveEdge = true;
+        continue;
+      }
+
+      period = t - lastEdge;
+      if (period < MinPeriodUs) {
+        continue;  // Ignore edge, keep measuring from the last real one
+      }
+      lastEdge = t;
+
+      periods[periodIndex] = period;
+      periodIndex = (periodIndex == 2) ? 0 : periodIndex + 1;
+      if (periodCount < 3) {
+        periodCount++;
+        periodEma = period;  // Seed EMA until the median has full history
+      } else {
+        unsigned long med = median3(periods[0], periods[1], periods[2]);
+        periodEma += ((long)med - (long)periodEma) >> EmaShift;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  unsigned long ema() const { return periodEma; }
+  bool hasEdge() const { return haveEdge; }
+  bool hasPeriod() const { return periodCount > 0; }
+
+  // Time since the last accepted edge (only meaningful with hasEdge())
+  unsigned long sinceLast() const { return micros() - lastEdge; }
+
+  // Edges dropped on a full ring (running total)
+  uint16_t overruns() const {
+    noInterrupts();
+    uint16_t n = overrunCount;
+    interrupts();
+    return n;
+  }
+
+ private:
+  static unsigned long median3(unsigned long a, unsigned long b, unsigned long c) {
+    if (a > b) { unsigned long t = a; a = b; b = t; }
+    if (b > c) { b = c; }
+    return (a > b) ? a : b;
+  }
+
+  RingBuffer<unsigned long, EdgeSlots> edges;  // ISR pushes, loop pops (no locking)
+  volatile uint16_t overrunCount = 0;
+
+  // Filter state (loop side only)
+  unsigned long lastEdge = 0;
+  bool haveEdge = false;
+  unsigned long periods[3];  // Last three periods for median-of-3
+  uint8_t periodIndex = 0;
+  uint8_t periodCount = 0;
+  unsigned long periodEma = 0;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <Arduino.h>
+
+// Fixed-size FIFO shared by the ISR -> loop and loop -> UART queues
+//
+// Single producer, single consumer. The producer only writes head, the
+// consumer only writes tail; both run free and wrap on their own, the slot is
+// index & (N - 1). Full vs empty needs no spare slot (count = head - tail).
+//
+// N is a power of two. Up to 128 the indices are one byte, and one-byte loads
+// and stores are atomic on AVR: an ISR on either side needs no locking. Above
+// 128 they are 16-bit (two accesses) - loop-only queues, or ATOMIC_BLOCK.
+// Every ring also has to fit RING_SRAM_BUDGET on its own (2KB on the Nano).
+
+static const uint16_t RING_SRAM_BUDGET = 256;
+
+// Index type by capacity (no <type_traits> on AVR)
+template <bool Wide> struct RingIndex { typedef uint8_t Type; };
+template <> struct RingIndex<true> { typedef uint16_t Type; };
+
+// Data stores must land before the index that publishes them and vice versa;
+// head/tail are volatile, this keeps the compiler from moving the slot access
+#define RING_BARRIER() asm volatile("" ::: "memory")
+
+template <typename T, uint16_t N>
+class RingBuffer {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+  static_assert(N <= 32768, "RingBuffer index is 16-bit");
+  static_assert(N * sizeof(T) <= RING_SRAM_BUDGET, "RingBuffer over its SRAM budget");
+
+ public:
+  typedef typename RingIndex<(N > 128)>::Type Index;
+  static const uint16_t CAPACITY = N;
+
+  // Producer side
+
+  bool push(const T& v) {
+    if (space() == 0) return false;
+    slot(0) = v;
+    publish(1);
+    return true;
+  }
+
+  // Batch push: fill slot(0..space()-1), then publish(n) makes them visible
+  // at once (a consumer never sees half a frame)
+  Index space() const { return N - count(); }
+  T& slot(Index i) { return buf_[(Index)(head_ + i) & MASK]; }
+  void publish(Index n) {
+    RING_BARRIER();
+    head_ = head_ + n;
+  }
+
+  // Consumer side
+
+  bool pop(T& out) {
+    if (empty()) return false;
+    out = (*this)[0];
+    drop(1);
+    return true;
+  }
+
+  // i = 0 is the oldest
+  T& operator[](Index i) {
+    RING_BARRIER();
+    return buf_[(Index)(tail_ + i) & MASK];
+  }
+  const T& operator[](Index i) const {
+    RING_BARRIER();
+    return buf_[(Index)(tail_ + i) & MASK];
+  }
+
+  void drop(Index n) {
+    RING_BARRIER();
+    tail_ = tail_ + n;
+  }
+
+  // Drop everything queued so far
+  void clear() { tail_ = head_; }
+
+  // Either side
+
+  Index count() const { return (Index)(head_ - tail_); }
+  bool empty() const { return head_ == tail_; }
+  bool full() const { return count() == N; }
+
+ private:
+  static const Index MASK = N - 1;
+
+  T buf_[N];
+  volatile Index head_ = 0;
+  volatile Index tail_ = 0;
+};
+
+#endif
@@ -1,5 +1,11 @@
 #include "rpm.h"
 #include <Arduino.h>
+#include "pulse.h"
+
+// 1 = fake ramp for bench testing without a tach signal
+#define RPM_MOCK 0
+
+#if RPM_MOCK
 
 // Mock RPM: ramps up/down between idle and redline
 static int _rpm = 800;
@@ -26,3 +32,58 @@ void rpm_update() {
 int rpm_get() {
   return _rpm;
 }
+
+uint16_t rpm_overruns() {
+  return 0;
+}
+
+#else
+
+// Tach input: conditioned ignition pulse (opto-isolated, active low) on D2
+// Timer1 input capture (ICP1 = D8) is taken by AltSoftSerial RX, so edges come
+// in on INT0 and get stamped with micros() (4us resolution - 0.07% at 10k RPM).
+// The ISR only stores the timestamp: a few us, well inside AltSoftSerial's
+// capture window (hardware-latched in ICR1) and the UART's 2-byte RX FIFO.
+static const uint8_t PIN_TACH = 2;
+static const uint8_t PULSES_PER_REV = 1;          // Single cylinder, one spark per rev
+static const unsigned long MIN_PERIOD_US = 60000000UL / (12000UL * PULSES_PER_REV);  // Faster = ringing
+static const unsigned long STALL_TIMEOUT_US = 500000;  // No pulse for 500ms = engine off
+static const uint8_t EMA_SHIFT = 2;               // alpha = 1/4
+
+// Edge timestamps and the median/EMA period filter (pulse.h)
+static PulseFilter<16, MIN_PERIOD_US, EMA_SHIFT> _pulses;  // ~95ms of pulses at 10k RPM
+static int _rpm = 0;
+
+static void onTachPulse() {
+  _pulses.edge();
+}
+
+void rpm_init() {
+  pinMode(PIN_TACH, INPUT_PULLUP);
+  _pulses.init();
+  _rpm = 0;
+  attachInterrupt(digitalPinToInterrupt(PIN_TACH), onTachPulse, FALLING);
+}
+
+void rpm_update() {
+  unsigned long period;  // Ringing on the pickup is dropped by the filter
+  while (_pulses.next(period)) {
+    _rpm = 60000000UL / (_pulses.ema() * PULSES_PER_REV);
+  }
+
+  // Engine stopped: no edges for a while
+  if (_pulses.hasEdge() && _pulses.sinceLast() > STALL_TIMEOUT_US) {
+    _pulses.reset();
+    _rpm = 0;
+  }
+}
+
+int rpm_get() {
+  return _rpm;
+}
+
+uint16_t rpm_overruns() {
+  return _pulses.overruns();
+}
+
+#endif
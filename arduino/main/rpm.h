@@ -1,8 +1,13 @@
 #ifndef RPM_H
 #define RPM_H
 
+#include <Arduino.h>
+
+// Tach pulses on D2 (INT0) are timestamped in an ISR; the period -> RPM
+// math and median/EMA filtering happen in rpm_update()
 void rpm_init();
-void rpm_update();      // Call in loop
-int rpm_get();          // Returns current RPM (0 if invalid)
+void rpm_update();      // Call in loop - drains pulse timestamps
+int rpm_get();          // Returns current RPM (0 if invalid / engine off)
+uint16_t rpm_overruns();  // Pulses dropped on a full edge buffer (running total)
 
 #endif
@@ -0,0 +1,91 @@
+#include "sched.h"
+#include "config.h"
+
+// Default periods (ms), used until a valid config record exists
+static const uint16_t DEFAULT_PERIOD_MS[SCHED_SLOTS] PROGMEM = {
+  100,   // TLM: 10Hz
+  0,     // IMU: every WT61 packet (IMU_RATE_HZ)
+  100,   // VBAT: 10Hz
+  100,   // RPM: 10Hz
+  250,   // GEAR: 4Hz
+  100,   // SPEED: 10Hz
+  1000,  // TEMP: 1Hz
+  1000,  // ITEMP: 1Hz
+  0,     // STATS: off
+  500,   // Heartbeat LED
+};
+
+// Command names for the rate-settable channels, in SchedChannel order
+static const char CHANNEL_NAMES[CH_RATE_COUNT][6] PROGMEM = {
+  "TLM", "IMU", "VBAT", "RPM", "GEAR", "SPEED", "TEMP", "ITEMP", "STATS",
+};
+
+// Longest accepted stored period - anything above means a bad record
+static const uint16_t MAX_PERIOD_MS = 60000;
+
+struct TaskSlot {
+  SchedTask task;
+  uint16_t periodMs;
+  unsigned long due;
+};
+static TaskSlot slots[SCHED_SLOTS];
+
+void sched_init() {
+  Config& cfg = config_get();
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < SCHED_SLOTS; i++) {
+    uint16_t period = pgm_read_word(&DEFAULT_PERIOD_MS[i]);
+    if (i < CH_RATE_COUNT) {
+      if (config_valid() && cfg.periodMs[i] <= MAX_PERIOD_MS) {
+        period = cfg.periodMs[i];
+      } else {
+        cfg.periodMs[i] = period;  // Defaults, should another module save first
+      }
+    }
+    slots[i].task = NULL;
+    slots[i].periodMs = period;
+    slots[i].due = now + period;
+  }
+}
+
+void sched_attach(SchedChannel ch, SchedTask task) {
+  slots[ch].task = task;
+}
+
+void sched_run(unsigned long now) {
+  for (uint8_t i = 0; i < SCHED_SLOTS; i++) {
+    TaskSlot& slot = slots[i];
+    if (slot.task == NULL || slot.periodMs == 0) continue;
+    if ((long)(now - slot.due) < 0) continue;
+
+    // Next deadline from the old one keeps the rate exact; if we fell more
+    // than a period behind, skip the missed runs instead of bursting
+    slot.due += slot.periodMs;
+    if ((long)(now - slot.due) >= 0) slot.due = now + slot.periodMs;
+    slot.task(now);
+  }
+}
+
+void sched_set_period(SchedChannel ch, uint16_t periodMs) {
+  slots[ch].periodMs = periodMs;
+  slots[ch].due = millis() + periodMs;
+}
+
+uint16_t sched_get_period(SchedChannel ch) {
+  return slots[ch].periodMs;
+}
+
+int8_t sched_channel(const char* name) {
+  for (uint8_t i = 0; i < CH_RATE_COUNT; i++) {
+    if (strcmp_P(name, CHANNEL_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+void sched_save() {
+  Config& cfg = config_get();
+  for (uint8_t i = 0; i < CH_RATE_COUNT; i++) {
+    cfg.periodMs[i] = slots[i].periodMs;
+  }
+  config_save();
+}
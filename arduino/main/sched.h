@@ -0,0 +1,47 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <Arduino.h>
+
+// Cooperative scheduler: one task slot per channel, each with a period and
+// a due time, run from loop() by sched_run(). Tasks must not block.
+enum SchedChannel : uint8_t {
+  // Rate-settable channels (CMD:SET_RATE, persisted in EEPROM)
+  CH_TELEMETRY = 0,  // TIMED frame period / EVENT stale-IMU fallback
+  CH_IMU,            // Min spacing of IMU frames in EVENT mode (0 = every WT61 packet)
+  CH_VOLTAGE,
+  CH_RPM,
+  CH_GEAR,
+  CH_SPEED,
+  CH_ENG_TEMP,
+  CH_IMU_TEMP,
+  CH_STATS,          // PERF line (0 = only on request)
+  CH_RATE_COUNT,
+  // Internal slots
+  CH_HEARTBEAT = CH_RATE_COUNT,
+  SCHED_SLOTS,
+};
+
+typedef void (*SchedTask)(unsigned long now);
+
+// Load periods (stored config, else defaults) - call after config_init()
+void sched_init();
+
+// Attach a task to a channel slot; it runs every period (0 = never)
+void sched_attach(SchedChannel ch, SchedTask task);
+
+// Run every task that is due - call in loop
+void sched_run(unsigned long now);
+
+// Change a channel period (ms), restarts its deadline from now
+void sched_set_period(SchedChannel ch, uint16_t periodMs);
+uint16_t sched_get_period(SchedChannel ch);
+
+// Channel by its command name (TLM, IMU, VBAT, RPM, GEAR, SPEED, TEMP, ITEMP, STATS),
+// -1 if unknown
+int8_t sched_channel(const char* name);
+
+// Persist the rate-settable periods (only changed EEPROM bytes are written)
+void sched_save();
+
+#endif
@@ -0,0 +1,16 @@
+#include "sensor.h"
+
+// Set from scheduler tasks, cleared when a frame goes out - both in loop()
+static uint8_t due = 0;
+
+uint8_t sensors_due() {
+  return due;
+}
+
+void sensors_mark_due(uint8_t groups) {
+  due |= groups;
+}
+
+void sensors_clear_due() {
+  due = 0;
+}
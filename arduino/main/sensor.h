@@ -0,0 +1,69 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <Arduino.h>
+#include "sched.h"
+
+// Sensor drivers: one struct of static members per input, put together in a
+// compile-time SensorList (sensors.h). Every call expands inline - no vtables
+// or function pointers on the AVR, and a driver that isn't listed costs nothing.
+//
+//   struct XxxSensor {
+//     static const uint8_t FIELD;          // Telemetry field it fills (comms.h)
+//     static const uint8_t GROUP;          // TLM_* group that field goes out in
+//     static const SchedChannel CHANNEL;   // Rate: the group is due once per period
+//     static void init();                  // From setup(), in list order
+//     static void update();                // Every loop(), in list order, non-blocking
+//     static int16_t read();               // Latest value, field units
+//     static bool valid();                 // False: no reading (yet) or sensor fault
+//   };
+//
+// Timestamps: update() does the filtering, read() gives the estimate as of now -
+// a frame without an IMU sample takes its t_ms from millis() at send time.
+// Per-driver sampling state (edge rings, ADC handlers) stays in the module.
+
+// TLM_* groups whose channel came up since the last frame
+uint8_t sensors_due();
+void sensors_mark_due(uint8_t groups);
+void sensors_clear_due();
+
+template <typename... Drivers> struct SensorList;
+
+template <> struct SensorList<> {
+  static void init() {}
+  static void update() {}
+  static void attach() {}
+  static uint8_t read(int16_t*) { return 0; }
+};
+
+template <typename First, typename... Rest>
+struct SensorList<First, Rest...> {
+  static void init() {
+    First::init();
+    SensorList<Rest...>::init();
+  }
+
+  static void update() {
+    First::update();
+    SensorList<Rest...>::update();
+  }
+
+  // Each driver's channel flags its group as due (call after sched_init())
+  static void attach() {
+    sched_attach(First::CHANNEL, markDue);
+    SensorList<Rest...>::attach();
+  }
+
+  // Fill every listed driver's field, returns the groups with a valid value
+  // (the rest are left out of the frame, the Pi keeps what it had)
+  static uint8_t read(int16_t* fields) {
+    fields[First::FIELD] = First::read();
+    uint8_t valid = First::valid() ? First::GROUP : 0;
+    return valid | SensorList<Rest...>::read(fields);
+  }
+
+ private:
+  static void markDue(unsigned long now) { sensors_mark_due(First::GROUP); }
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "sensor.h"
+#include "comms.h"
+#include "voltage.h"
+#include "rpm.h"
+#include "speed.h"
+#include "gear.h"
+#include "engtemp.h"
+#include "imu.h"
+
+// The telemetry inputs besides the IMU motion fields, as SensorList drivers
+// (sensor.h). Those stay outside: nine fields, and their frames follow WT61
+// packets rather than a channel rate (main.ino, comms.h)
+
+struct VoltageSensor {
+  static const uint8_t FIELD = FIELD_VBAT;
+  static const uint8_t GROUP = TLM_VOLTAGE;
+  static const SchedChannel CHANNEL = CH_VOLTAGE;
+  static void init() { voltage_init(); }  // First adc.h user, see voltage.h
+  static void update() {}                 // Sampled by the ADC in the background
+  static int16_t read() { return voltage_read_mv(); }
+  static bool valid() { return true; }
+};
+
+struct RpmSensor {
+  static const uint8_t FIELD = FIELD_RPM;
+  static const uint8_t GROUP = TLM_RPM;
+  static const SchedChannel CHANNEL = CH_RPM;
+  static void init() { rpm_init(); }
+  static void update() { rpm_update(); }  // Drain tach timestamps
+  static int16_t read() { return rpm_get(); }
+  static bool valid() { return true; }
+};
+
+struct SpeedSensor {
+  static const uint8_t FIELD = FIELD_SPEED;
+  static const uint8_t GROUP = TLM_SPEED;
+  static const SchedChannel CHANNEL = CH_SPEED;
+  static void init() { speed_init(); }
+  static void update() { speed_update(); }  // Drain wheel pulse timestamps
+  static int16_t read() { return speed_get(); }
+  static bool valid() { return true; }
+};
+
+// After RPM and speed: the ratio estimate uses both, fresh from this loop
+struct GearSensor {
+  static const uint8_t FIELD = FIELD_GEAR;
+  static const uint8_t GROUP = TLM_GEAR;
+  static const SchedChannel CHANNEL = CH_GEAR;
+  static void init() { gear_init(); }
+  static void update() { gear_update(rpm_get(), speed_get()); }
+  static int16_t read() { return gear_get(); }
+  static bool valid() { return true; }
+};
+
+struct EngTempSensor {
+  static const uint8_t FIELD = FIELD_ENG_TEMP;
+  static const uint8_t GROUP = TLM_ENG_TEMP;
+  static const SchedChannel CHANNEL = CH_ENG_TEMP;
+  static void init() { engtemp_init(); }
+  static void update() { engtemp_update(); }  // Convert the averaged ADC readings
+  static int16_t read() { return engtemp_get(); }
+  static bool valid() { return engtemp_valid(); }
+};
+
+// The WT61's die temperature, parsed with the motion packets (imu.h)
+struct ImuTempSensor {
+  static const uint8_t FIELD = FIELD_IMU_TEMP;
+  static const uint8_t GROUP = TLM_IMU_TEMP;
+  static const SchedChannel CHANNEL = CH_IMU_TEMP;
+  static void init() {}    // Done by imu_init()
+  static void update() {}  // and imu_update()
+  static int16_t read() { return imu_temp(); }
+  static bool valid() { return imu_is_fresh(); }
+};
+
+// Order is init / update order
+typedef SensorList<VoltageSensor, RpmSensor, SpeedSensor, GearSensor, EngTempSensor,
+                   ImuTempSensor> Sensors;
+
+#endif
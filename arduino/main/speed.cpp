@@ -0,0 +1,62 @@
+#include "speed.h"
+#include "pulse.h"
+
+// Wheel pickup: hall sensor or reed switch (active low, to GND) on D3
+// Same scheme as the tach (rpm.cpp): INT1 stamps micros(), loop does the math.
+// Edit for your bike: roll the wheel one turn and measure the distance, and
+// count the magnets / disc bolts the pickup sees per turn.
+static const uint8_t PIN_WHEEL = 3;
+static const uint16_t WHEEL_CIRC_MM = 2100;
+static const uint8_t PULSES_PER_REV = 1;
+
+// 0.1 km/h = SPEED_K / period_us (mm/us x 36000)
+static const unsigned long SPEED_K = (unsigned long)WHEEL_CIRC_MM * 36000UL / PULSES_PER_REV;
+static const uint16_t MAX_SPEED = 2000;  // 200 km/h - faster = reed bounce
+static const uint16_t MIN_SPEED = 30;    // 3 km/h - slower reads as stopped
+static const unsigned long MIN_PERIOD_US = SPEED_K / MAX_SPEED;
+static const unsigned long STALL_TIMEOUT_US = SPEED_K / MIN_SPEED;  // ~2.5s
+static const uint8_t EMA_SHIFT = 1;  // alpha = 1/2 - a pulse per turn is slow enough already
+
+// Edge timestamps and the median/EMA period filter (pulse.h)
+static PulseFilter<8, MIN_PERIOD_US, EMA_SHIFT> _pulses;  // ~300ms of pulses at 200 km/h
+static int _speed = 0;
+
+static void onWheelPulse() {
+  _pulses.edge();
+}
+
+void speed_init() {
+  pinMode(PIN_WHEEL, INPUT_PULLUP);
+  _pulses.init();
+  _speed = 0;
+  attachInterrupt(digitalPinToInterrupt(PIN_WHEEL), onWheelPulse, FALLING);
+}
+
+void speed_update() {
+  unsigned long period;  // Contact bounce is dropped by the filter
+  while (_pulses.next(period)) {
+    // A late pulse shows as is, like the cap below: slowing down is never
+    // held back by the filter (a missed pulse reads low for one turn)
+    unsigned long ema = _pulses.ema();
+    _speed = SPEED_K / (period > ema ? period : ema);
+  }
+  if (!_pulses.hasEdge()) return;
+
+  // Braking: the next pulse is up to a turn away, but the time since the
+  // last one already caps the speed - follow it down between pulses
+  unsigned long since = _pulses.sinceLast();
+  if (since > STALL_TIMEOUT_US) {
+    _pulses.reset();  // Stopped
+    _speed = 0;
+  } else if (_pulses.hasPeriod() && since > _pulses.ema()) {
+    _speed = SPEED_K / since;
+  }
+}
+
+int speed_get() {
+  return _speed;
+}
+
+uint16_t speed_overruns() {
+  return _pulses.overruns();
+}
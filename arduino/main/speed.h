@@ -0,0 +1,14 @@
+#ifndef SPEED_H
+#define SPEED_H
+
+#include <Arduino.h>
+
+// Wheel speed from a hall/reed pickup on D3 (INT1): pulses are timestamped in
+// an ISR, the period -> speed math and filtering happen in speed_update()
+// Wheel size and pulses per turn are set at the top of speed.cpp
+void speed_init();
+void speed_update();        // Call in loop - drains pulse timestamps
+int speed_get();            // 0.1 km/h (0 = stopped / below ~3 km/h)
+uint16_t speed_overruns();  // Pulses dropped on a full edge buffer (running total)
+
+#endif
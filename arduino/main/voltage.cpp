@@ -1,4 +1,6 @@
 #include "voltage.h"
+#include "adc.h"
+#include "ringbuf.h"
 
 // Pin definitions
 static const int PIN_VBAT = A0;
@@ -7,54 +9,145 @@ static const int PIN_VBAT = A0;
 // Divider: 100k upper (to Vin), 47k lower (to GND)
 // Vout = Vin * (47k / (100k + 47k)) = Vin * 0.3197
 // At 12V: ADC sees 3.84V | At 14.4V: ADC sees 4.60V
-static const float DIVIDER_RATIO = 47.0 / (100.0 + 47.0);  // ~0.3197
-static const float ADC_REF = 5.0;
-static const int ADC_MAX = 1023;
-static const float OFFSET = 0.2; // calib
+static constexpr float DIVIDER_RATIO = 47.0 / (100.0 + 47.0);  // ~0.3197
+static constexpr float ADC_REF = 5.0;
+static constexpr int ADC_MAX = 1023;
+static const int OFFSET_MV = 200; // calib
+
+// Divider + reference folded into one Q8 fixed-point constant at compile time:
+// mV = counts * MV_PER_COUNT_Q8 >> 8  (~15.29 mV per ADC count)
+static constexpr uint16_t MV_PER_COUNT_Q8 =
+    (uint16_t)(ADC_REF * 1000.0 / ADC_MAX / DIVIDER_RATIO * 256.0 + 0.5);
+
+// ADC sampling: background conversions at ADC_PIN_HZ (adc.h, 244Hz) - reads
+// never block. Every DECIMATION conversions are averaged into one window
+// sample (~122Hz), so the default 16-sample window spans ~130ms regardless of
+// telemetry rate.
+static const uint8_t DECIMATION = 2;  // Keep a power of two
 
 // Sliding window smoother (max 32 samples to keep RAM usage sane)
-static const int MAX_WINDOW = 32;
-static int _samples[MAX_WINDOW];
-static int _windowSize = 20;  // Active window size
-static int _sampleIndex = 0;
-static long _sampleSum = 0;
+// Power-of-two sizes only, so the average is a shift; the ring holds exactly
+// the active window. Written from the ADC handler (ADC_vect on the 328P)
+static const uint8_t MAX_WINDOW_SHIFT = 5;
+static const uint8_t MAX_WINDOW = 1 << MAX_WINDOW_SHIFT;
+static RingBuffer<uint16_t, MAX_WINDOW> _samples;
+static volatile uint8_t _windowShift = 4;  // Active window size = 1 << shift
+static volatile uint16_t _sampleSum = 0;   // Max 32 * 1023, fits
+static volatile uint16_t _lastRaw = 0;
+
+// Between-frame aggregate of the window samples (voltage_take_stats)
+static volatile uint16_t _aggMin = 0;
+static volatile uint16_t _aggMax = 0;
+static volatile uint32_t _aggSum = 0;
+static volatile uint16_t _aggCount = 0;
+
+static void pushSample(uint16_t raw) {
+  _lastRaw = raw;
+  if (_aggCount == 0 || raw < _aggMin) _aggMin = raw;
+  if (_aggCount == 0 || raw > _aggMax) _aggMax = raw;
+  if (_aggCount < 0xFFFF) {
+    _aggSum += raw;
+    _aggCount++;
+  }
+
+  if (_samples.count() >> _windowShift) {  // Window full - remove oldest
+    _sampleSum -= _samples[0];
+    _samples.drop(1);
+  }
+  _samples.push(raw);
+  _sampleSum += raw;
+}
+
+static uint16_t _decimSum = 0;
+static uint8_t _decimCount = 0;
+
+static void onAdcSample(uint16_t raw) {
+  _decimSum += raw;
+  if (++_decimCount < DECIMATION) return;
+
+  pushSample(_decimSum / DECIMATION);  // Power of two - compiles to a shift
+  _decimSum = 0;
+  _decimCount = 0;
+}
 
 void voltage_init() {
-  voltage_set_smoothing(20);  // Default 20 samples
+  // Seed with one blocking read while the ADC is still in single-shot mode
+  _lastRaw = analogRead(PIN_VBAT);
+  voltage_set_smoothing(16);  // Default 16 samples (~130ms)
+  adc_attach(PIN_VBAT, onAdcSample);
 }
 
-void voltage_set_smoothing(int windowSize) {
-  // Clamp to valid range
-  if (windowSize < 1) windowSize = 1;
-  if (windowSize > MAX_WINDOW) windowSize = MAX_WINDOW;
-  _windowSize = windowSize;
+int voltage_set_smoothing(int windowSize) {
+  // Round down to a power of two within 1..MAX_WINDOW
+  uint8_t shift = 0;
+  while (shift < MAX_WINDOW_SHIFT && (2 << shift) <= windowSize) shift++;
+  uint8_t size = 1 << shift;
 
   // Pre-fill window with current reading
-  int initial = analogRead(PIN_VBAT);
-  for (int i = 0; i < _windowSize; i++) {
-    _samples[i] = initial;
+  noInterrupts();
+  uint16_t initial = _lastRaw;
+  _windowShift = shift;
+  _samples.clear();
+  for (uint8_t i = 0; i < size; i++) {
+    _samples.push(initial);
   }
-  _sampleSum = (long)initial * _windowSize;
-  _sampleIndex = 0;
+  _sampleSum = initial << shift;
+  interrupts();
+
+  return size;
 }
 
 int voltage_read_raw() {
-  return analogRead(PIN_VBAT);
+  return _lastRaw;  // Latest decimated sample - the ADC belongs to adc.cpp
+}
+
+// Snapshot window sum and shift together (both change in ADC_vect / set_smoothing)
+static void readWindow(uint16_t& sum, uint8_t& shift) {
+  noInterrupts();
+  sum = _sampleSum;
+  shift = _windowShift;
+  interrupts();
 }
 
 int voltage_read_smoothed() {
-  int raw = analogRead(PIN_VBAT);
+  uint16_t sum;
+  uint8_t shift;
+  readWindow(sum, shift);
+  return sum >> shift;
+}
+
+int voltage_read_mv() {
+  // Scale the full window sum, not the average, to keep sub-count resolution
+  uint16_t sum;
+  uint8_t shift;
+  readWindow(sum, shift);
+  return (int)(((uint32_t)sum * MV_PER_COUNT_Q8) >> (8 + shift)) + OFFSET_MV;
+}
+
+static int countsToMv(uint16_t counts) {
+  return (int)(((uint32_t)counts * MV_PER_COUNT_Q8) >> 8) + OFFSET_MV;
+}
 
-  _sampleSum -= _samples[_sampleIndex];   // Remove oldest
-  _samples[_sampleIndex] = raw;            // Store new
-  _sampleSum += raw;                       // Add new
-  _sampleIndex = (_sampleIndex + 1) % _windowSize;
+void voltage_take_stats(VoltageStats& stats) {
+  noInterrupts();
+  uint16_t count = _aggCount;
+  uint16_t lo = _aggMin;
+  uint16_t hi = _aggMax;
+  uint32_t sum = _aggSum;
+  _aggCount = 0;
+  _aggSum = 0;
+  interrupts();
 
-  return _sampleSum / _windowSize;
+  stats.count = count;
+  if (count == 0) return;
+  stats.minMv = countsToMv(lo);
+  stats.maxMv = countsToMv(hi);
+  // Mean in Q8 counts (whole + fraction, no 32-bit overflow for long frames)
+  // keeps sub-count resolution, as voltage_read_mv()
+  uint32_t meanQ8 = (sum / count) * 256 + (sum % count) * 256 / count;
+  stats.meanMv = (int)((meanQ8 * MV_PER_COUNT_Q8) >> 16) + OFFSET_MV;
 }
 
 float voltage_read() {
-  int raw = voltage_read_smoothed();
-  float vDivider = (raw / (float)ADC_MAX) * ADC_REF;
-  return vDivider / DIVIDER_RATIO + OFFSET;
+  return voltage_read_mv() * 0.001;
 }
@@ -3,20 +3,35 @@
 
 #include <Arduino.h>
 
-// Initialize voltage monitoring (call in setup)
+// Initialize voltage monitoring (call in setup, before other adc.h users)
+// Starts background ADC sampling (adc.h, decimated into the smoothing window)
 void voltage_init();
 
-// Set smoothing window size (1-32 samples, default 20)
+// Set smoothing window size (1-32 samples, default 16)
+// Rounded down to a power of two; returns the size actually used
 // Resets the buffer with current reading
-void voltage_set_smoothing(int windowSize);
+int voltage_set_smoothing(int windowSize);
+
+// Read battery voltage (smoothed), returns millivolts (e.g., 12500)
+// Integer-only, non-blocking: the ADC is sampled in the background
+int voltage_read_mv();
 
 // Read battery voltage (smoothed), returns volts (e.g., 12.5)
+// Thin float wrapper around voltage_read_mv()
 float voltage_read();
 
 // Read smoothed ADC value (averaged over window)
 int voltage_read_smoothed();
 
-// Read raw ADC value (0-1023), no smoothing
+// Read latest ADC sample (0-1023), no window smoothing
 int voltage_read_raw();
 
+// Every window sample (~122Hz) since the last call, for frame aggregation
+// Restarts the count; count = 0 means no new sample (the rest is then unset)
+struct VoltageStats {
+  uint16_t count;
+  int minMv, maxMv, meanMv;
+};
+void voltage_take_stats(VoltageStats& stats);
+
 #endif
@@ -1,8 +1,10 @@
 """Arduino service - connects to Arduino Nano via serial, buffers telemetry."""
 
+import binascii
 import json
 import math
 import re
+import struct
 import threading
 import time
 from collections import deque
@@ -19,7 +21,11 @@ class ArduinoService:
     """Threaded Arduino serial reader with buffering and auto-reconnect."""
 
     # TSV field names (order per PROTOCOL.md)
-    TSV_FIELDS = ['voltage', 'ax', 'ay', 'az', 'gx', 'gy', 'gz', 'roll', 'pitch', 'yaw', 'rpm', 'gear']
+    TSV_FIELDS = ['voltage', 'ax', 'ay', 'az', 'gx', 'gy', 'gz', 'roll', 'pitch', 'yaw', 'rpm', 'gear', 'speed',
+                  'eng_temp', 'imu_temp']
+    # Older firmware sends a prefix of TSV_FIELDS: TSV column count -> fields
+    # (12: before speed, 14: + seq/t_ms, 15: speed, 17: temperatures)
+    TSV_LAYOUTS = {12: 12, 14: 12, 15: 13, 17: 15}
 
     # Regex patterns for legacy text protocol (backwards compatibility)
     PATTERNS = {
@@ -32,18 +38,78 @@ class ArduinoService:
     # ACK pattern: "ACK:CMD:STATUS" or "ACK:CMD:STATUS:extra"
     ACK_PATTERN = re.compile(r"ACK:(\w+):(\w+)(?::(.*))?")
 
+    # Alert event line: "ALERT:RULE:ON|OFF:v=<value>:t=<ms>" (TSV format)
+    ALERT_PATTERN = re.compile(r"ALERT:(\w+):(ON|OFF):v=(-?\d+):t=(\d+)")
+
+    # Alert rules by binary index, with their value units (per PROTOCOL.md)
+    ALERT_RULES = ['VLOW', 'VHIGH', 'REV', 'LEAN', 'ACCEL']
+
+    # Perf stats line: "PERF:key=value:key=value..." (reply to CMD:PERF)
+    PERF_PATTERN = re.compile(r"PERF:(.*)")
+
+    # Binary frame constants (per PROTOCOL.md)
+    FRAME_SYNC = b"\xa5\x5a"
+    PROTOCOL_VERSION = 4
+    SUPPORTED_VERSIONS = (1, 2, 3, 4)  # v1: no t_ms in telemetry payload, v3: speed, v4: temperatures
+    FRAME_TELEMETRY = 0x01
+    FRAME_IMU_BATCH = 0x02
+    FRAME_ALERT = 0x03
+    FRAME_RANGE = 0x04
+    IMU_FIELDS = TSV_FIELDS[1:10]  # ax..yaw, in batch sample order
+
+    # CMD:PING:hb=<n> interval while connected: the firmware takes 5s without a
+    # command as "Pi gone" and powers down once the bike is parked (PROTOCOL.md)
+    HEARTBEAT_S = 2.0
+
+    # Link negotiation (CMD:HELLO, per PROTOCOL.md): bit i of the bauds mask is
+    # LINK_BAUDS[i], bit i of the fmts mask is LINK_FORMATS[i]
+    LINK_BAUDS = (115200, 250000, 500000, 1000000)
+    LINK_FORMATS = ("tsv", "bin", "batch")
+    HELLO_TRIES = 5          # 1s apart - covers the bootloader after a DTR reset
+    LINK_CONFIRM_S = 2.0     # Firmware drops back to its boot rate without a command this soon
+    LINK_TIMEOUT_S = 3.0     # No valid frame for this long at a negotiated rate: reconnect
+    LINK_STRIKES = 2         # Failed confirms/timeouts before a rate is no longer offered
+
+    # Binary field scales (int16 -> engineering units), same order as TSV_FIELDS
+    # Voltage in mV, IMU in raw WT61 LSBs (see IMU.md), RPM/gear as-is, speed in 0.1 km/h,
+    # temperatures in 0.1 °C
+    BIN_SCALES = [
+        0.001,
+        16.0 / 32768, 16.0 / 32768, 16.0 / 32768,
+        2000.0 / 32768, 2000.0 / 32768, 2000.0 / 32768,
+        180.0 / 32768, 180.0 / 32768, 180.0 / 32768,
+        1, 1,
+        0.1,
+        0.1, 0.1,
+    ]
+
     def __init__(
         self,
         port: str = "/dev/serial0",
         baudrate: int = 115200,
         buffer_size: int = 100,
+        frame_format: str = "tsv",
+        frame_stat: str = "last",
+        frame_range: bool = False,
+        max_baudrate: int = 1000000,
     ):
         self.port = port
-        self.baudrate = baudrate
+        self.baudrate = baudrate  # The Arduino boots at this rate
+        # Highest rate offered in the connect handshake (= baudrate: stay there)
+        self.max_baudrate = max_baudrate
         self.buffer_size = buffer_size
+        self.frame_format = frame_format  # "tsv" (debug), "bin" or "batch", requested on connect
+        # Between-frame aggregation, also requested on connect: V_bat/IMU fields
+        # carry the "last" sample, the "mean" or the "peak"; frame_range adds
+        # "<field>_min"/"_max" (binary formats only)
+        self.frame_stat = frame_stat
+        self.frame_range = frame_range
 
         self._buffer: deque[dict[str, Any]] = deque(maxlen=buffer_size)
         self._latest: dict[str, Any] = {}
+        self._perf: dict[str, Any] = {}
+        # Batched IMU samples (FORMAT BATCH), timestamped on the Arduino
+        self._imu_series: deque[dict[str, Any]] = deque(maxlen=buffer_size * 10)
         self._connected = False
         self._running = False
         self._thread: threading.Thread | None = None
@@ -52,6 +118,7 @@ class ArduinoService:
         # Callbacks for push-based updates
         self._on_data_callback = None
         self._on_ack_callback = None
+        self._on_alert_callback = None
 
         # Serial port handle for sending commands
         self._serial: Any = None
@@ -60,6 +127,22 @@ class ArduinoService:
         # Periodic status logging
         self._last_status_log = 0.0
         self._frame_count = 0
+        self._crc_errors = 0
+
+        # Link loss tracking from frame sequence numbers
+        self._seq_last: int | None = None
+        self._frames_dropped = 0
+
+        # Heartbeat PINGs: their ACKs (extra "hb=<n>") stay out of the ACK callback
+        self._last_heartbeat = 0.0
+        self._heartbeat_seq = 0
+
+        # Negotiated link: rate in use, firmware protocol version (None: no HELLO
+        # support), failures per rate
+        self._link_baud = baudrate
+        self._link_version: int | None = None
+        self._link_strikes: dict[int, int] = {}
+        self._last_good = 0.0
 
     def set_on_data(self, callback):
         """Set callback for new telemetry data. Called with data dict."""
@@ -69,7 +152,12 @@ class ArduinoService:
         """Set callback for ACK responses. Called with (cmd, status, extra)."""
         self._on_ack_callback = callback
 
-    def send_command(self, cmd: str, params: dict | None = None) -> bool:
+    def set_on_alert(self, callback):
+        """Set callback for firmware alert events. Called with an alert dict
+        (rule, active, value, t_ms) as soon as the frame arrives."""
+        self._on_alert_callback = callback
+
+    def send_command(self, cmd: str, params: dict | None = None, quiet: bool = False) -> bool:
         """Send a command to Arduino via serial.
 
         Format: "CMD:NAME:PARAM1:PARAM2..." followed by newline
@@ -77,6 +165,7 @@ class ArduinoService:
         Args:
             cmd: Command name (e.g., "HORN", "LIGHT")
             params: Optional parameters dict
+            quiet: Don't log the line (heartbeat)
 
         Returns:
             True if sent successfully, False if serial unavailable
@@ -96,7 +185,8 @@ class ArduinoService:
 
                 self._serial.write(line.encode("utf-8"))
                 self._serial.flush()
-                print(f"[Arduino] Sent: {line.strip()}")
+                if not quiet:
+                    print(f"[Arduino] Sent: {line.strip()}")
                 return True
             except Exception as e:
                 print(f"[Arduino] Failed to send command: {e}")
@@ -111,6 +201,30 @@ class ArduinoService:
         with self._lock:
             return self._latest.copy() if self._latest else {"error": "no data"}
 
+    def get_link_stats(self) -> dict[str, int | None]:
+        """Frames lost (sequence gaps) and rejected (bad CRC) since connect,
+        baud rate in use and the firmware's protocol version (from HELLO)."""
+        return {
+            "frames_dropped": self._frames_dropped,
+            "crc_errors": self._crc_errors,
+            "baud": self._link_baud,
+            "protocol_version": self._link_version,
+        }
+
+    def get_perf(self) -> dict[str, Any]:
+        """Get last firmware perf counters (request with send_command("PERF"))."""
+        with self._lock:
+            return self._perf.copy() if self._perf else {"error": "no data"}
+
+    def get_imu_series(self) -> list[dict[str, Any]]:
+        """Get batched IMU samples, oldest first.
+
+        Each carries "t_us" (Arduino micros(), wraps at 2^32) for a uniform
+        time base. Only filled when frame_format is "batch".
+        """
+        with self._lock:
+            return list(self._imu_series)
+
     def get_buffer(self) -> list[dict[str, Any]]:
         """Get buffered telemetry history."""
         with self._lock:
@@ -161,27 +275,105 @@ class ArduinoService:
             with self._serial_lock:
                 self._serial = ser
             self._connected = True
+            self._link_baud = self.baudrate
+            print(f"[Arduino] Connected to {self.port} @ {self.baudrate} baud")
+
+            formats = self._negotiate_link(ser)
             self._last_status_log = time.time()
+            self._last_good = time.time()
             self._frame_count = 0
-            print(f"[Arduino] Connected to {self.port} @ {self.baudrate} baud")
+            self._crc_errors = 0
+            self._seq_last = None
+            self._frames_dropped = 0
+            self._last_heartbeat = time.time()
+
+            # Arduino boots in the format it last saved - always ask for ours,
+            # or the most compact one it has
+            frame_format = self.frame_format
+            if formats is not None and frame_format not in formats:
+                frame_format = "bin" if "bin" in formats else "tsv"
+            mode = {"tsv": "TSV", "bin": "BIN", "batch": "BATCH"}.get(frame_format)
+            if mode:
+                self.send_command("FORMAT", {"mode": mode})
+            if self.frame_stat != "last" or self.frame_range:
+                self.send_command("AGG", {
+                    "stat": self.frame_stat.upper(),
+                    "range": int(self.frame_range),
+                })
 
             while self._running:
                 try:
-                    # Read null-terminated line (TSV protocol)
-                    line = self._read_null_terminated(ser)
-                    if not line:
+                    # Garbled frames only (or none) at the negotiated rate - start
+                    # over at the boot rate, the firmware falls back on the garbage
+                    if (self._link_baud != self.baudrate
+                            and time.time() - self._last_good > self.LINK_TIMEOUT_S):
+                        print(f"[Arduino] No valid frames @ {self._link_baud} baud, reconnecting")
+                        self._link_strike(self._link_baud)
+                        break
+
+                    # Keep the Arduino from taking the Pi for gone (and powering down)
+                    if time.time() - self._last_heartbeat >= self.HEARTBEAT_S:
+                        self._last_heartbeat = time.time()
+                        self._heartbeat_seq = (self._heartbeat_seq + 1) & 0xFF
+                        self.send_command("PING", {"hb": self._heartbeat_seq}, quiet=True)
+
+                    # Read one frame: binary (bytes) or null/newline-terminated text (str)
+                    frame = self._read_frame(ser)
+                    if not frame:
                         continue
 
-                    # Check for ACK responses first (legacy newline-terminated)
-                    ack_match = self.ACK_PATTERN.match(line)
-                    if ack_match:
-                        cmd, status, extra = ack_match.groups()
-                        if self._on_ack_callback:
-                            self._on_ack_callback(cmd, status, extra)
-                        continue
-
-                    data = self._parse_line(line)
+                    if isinstance(frame, bytes):
+                        self._last_good = time.time()
+                        self._track_seq(frame[2])
+                        alert = self._parse_alert_frame(frame)
+                        if alert:
+                            self._dispatch_alert(alert)
+                            continue
+                        samples = self._parse_imu_batch(frame)
+                        if samples:
+                            with self._lock:
+                                self._imu_series.extend(samples)
+                            # Latest sample stands in for a regular IMU update
+                            data = {k: v for k, v in samples[-1].items() if k != "t_us"}
+                        elif frame[1] == self.FRAME_RANGE:
+                            data = self._parse_range(frame)
+                        else:
+                            data = self._parse_binary(frame)
+                    else:
+                        # Check for ACK responses first (legacy newline-terminated)
+                        ack_match = self.ACK_PATTERN.match(frame)
+                        if ack_match:
+                            self._last_good = time.time()
+                            cmd, status, extra = ack_match.groups()
+                            if cmd == "PING" and extra and extra.startswith("hb="):
+                                continue  # Heartbeat
+                            if self._on_ack_callback:
+                                self._on_ack_callback(cmd, status, extra)
+                            continue
+
+                        alert_match = self.ALERT_PATTERN.match(frame)
+                        if alert_match:
+                            rule, state, value, t_ms = alert_match.groups()
+                            self._dispatch_alert({
+                                "rule": rule,
+                                "active": state == "ON",
+                                "value": int(value),
+                                "t_ms": int(t_ms),
+                            })
+                            continue
+
+                        perf_match = self.PERF_PATTERN.match(frame)
+                        if perf_match:
+                            perf = self._parse_perf(perf_match.group(1))
+                            with self._lock:
+                                self._perf = perf
+                            continue
+
+                        data = self._parse_line(frame)
+                        if data and data.get("seq") is not None:
+                            self._track_seq(data["seq"])
                     if data:
+                        self._last_good = time.time()
                         data["time"] = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime())
                         with self._lock:
                             # Merge new values into latest (preserve old values for partial updates)
@@ -205,7 +397,7 @@ class ArduinoService:
                             rpm = self._latest.get('rpm', 0)
                             gear = self._latest.get('gear', 0)
                             roll = self._latest.get('roll', 0)
-                            print(f"[Arduino] {fps:.1f} fps | V={v:.1f} RPM={int(rpm)} G={int(gear)} roll={roll:.1f}°")
+                            print(f"[Arduino] {fps:.1f} fps | V={v:.1f} RPM={int(rpm)} G={int(gear)} roll={roll:.1f}° crc_err={self._crc_errors} dropped={self._frames_dropped}")
                             self._last_status_log = now
                             self._frame_count = 0
 
@@ -219,11 +411,93 @@ class ArduinoService:
                 self._serial = None
             ser.close()
 
-    def _read_null_terminated(self, ser) -> str:
-        """Read bytes until null terminator or newline (fallback for legacy)."""
+    def _negotiate_link(self, ser) -> set[str] | None:
+        """HELLO handshake: move both ends to the fastest rate both list.
+
+        Returns the frame formats the firmware has, None if it doesn't know
+        HELLO (older firmware: the link stays at self.baudrate).
+        """
+        offer = [i for i, baud in enumerate(self.LINK_BAUDS)
+                 if baud == self.baudrate or (self.baudrate < baud <= self.max_baudrate
+                                              and self._link_strikes.get(baud, 0) < self.LINK_STRIKES)]
+        hello = {
+            "bauds": sum(1 << i for i in offer),
+            "fmts": (1 << len(self.LINK_FORMATS)) - 1,
+        }
+        reply = None
+        for _ in range(self.HELLO_TRIES):
+            if not self.send_command("HELLO", hello):
+                return None
+            reply = self._await_ack(ser, "HELLO", 1.0)
+            if reply:
+                break
+        if reply is None or reply[0] != "OK":
+            print("[Arduino] No HELLO support, staying at the boot rate")
+            return None
+
+        caps = dict(kv.split("=", 1) for kv in (reply[1] or "").split(":") if "=" in kv)
+        self._link_version = int(caps.get("ver", 0)) or None
+        if self._link_version and self._link_version not in self.SUPPORTED_VERSIONS:
+            print(f"[Arduino] Firmware protocol v{self._link_version} not supported, binary frames will be skipped")
+        fmts = int(caps.get("fmts", 0))
+        formats = {name for i, name in enumerate(self.LINK_FORMATS) if fmts >> i & 1}
+
+        # The firmware switches right after its ACK and waits for a command at
+        # the new rate: a PING confirms it
+        baud = int(caps.get("baud", self.baudrate))
+        if baud != self.baudrate:
+            ser.baudrate = baud
+            self._link_baud = baud
+            for _ in range(3):
+                if self.send_command("PING") and self._await_ack(ser, "PING", 0.5):
+                    print(f"[Arduino] Link @ {baud} baud")
+                    return formats
+            print(f"[Arduino] No reply @ {baud} baud, back to {self.baudrate}")
+            self._link_strike(baud)
+            ser.baudrate = self.baudrate
+            self._link_baud = self.baudrate
+            time.sleep(self.LINK_CONFIRM_S)  # Until the firmware has given up too
+            ser.reset_input_buffer()
+        return formats
+
+    def _await_ack(self, ser, cmd: str, timeout: float) -> tuple[str, str | None] | None:
+        """Read until ACK:<cmd> arrives, for up to `timeout` seconds; other
+        frames are dropped. Returns (status, extra), or None on timeout."""
+        deadline = time.time() + timeout
+        while self._running and time.time() < deadline:
+            frame = self._read_frame(ser)
+            if isinstance(frame, str):
+                ack_match = self.ACK_PATTERN.match(frame)
+                if ack_match and ack_match.group(1) == cmd:
+                    return ack_match.group(2), ack_match.group(3)
+        return None
+
+    def _link_strike(self, baud: int):
+        """Count a failure at `baud`; after LINK_STRIKES, stop offering it."""
+        self._link_strikes[baud] = self._link_strikes.get(baud, 0) + 1
+        if self._link_strikes[baud] == self.LINK_STRIKES:
+            print(f"[Arduino] No longer offering {baud} baud")
+
+    def _track_seq(self, seq: int):
+        """Count frames lost on the link from gaps in the uint8 sequence number."""
+        if self._seq_last is not None:
+            self._frames_dropped += (seq - self._seq_last - 1) & 0xFF
+        self._seq_last = seq
+
+    def _read_frame(self, ser) -> str | bytes:
+        """Read one frame from serial.
+
+        Binary frames (sync 0xA5 0x5A at start of frame) are returned as bytes
+        from the version byte through the payload, CRC already checked.
+        Anything else is text read until null terminator or newline (legacy).
+        """
         buf = bytearray()
         while self._running:
             byte = ser.read(1)
+            if not buf and byte == self.FRAME_SYNC[:1]:
+                if ser.read(1) == self.FRAME_SYNC[1:]:
+                    return self._read_binary_frame(ser)
+                continue  # Lone 0xA5 - garbage, keep scanning
             if not byte:
                 # Timeout
                 if buf:
@@ -241,6 +515,140 @@ class ArduinoService:
             if len(buf) > 256:
                 return buf.decode("utf-8", errors="ignore").strip()
 
+    def _read_binary_frame(self, ser) -> bytes:
+        """Read the rest of a binary frame after the sync bytes.
+
+        Returns version..payload bytes, or b"" on timeout/CRC mismatch.
+        """
+        header = ser.read(4)  # version, type, seq, len
+        if len(header) < 4:
+            return b""
+        rest = ser.read(header[3] + 2)  # payload + crc16
+        if len(rest) < header[3] + 2:
+            return b""
+        body = header + rest[:-2]
+        crc = rest[-2] | (rest[-1] << 8)
+        if binascii.crc_hqx(body, 0xFFFF) != crc:
+            self._crc_errors += 1
+            return b""
+        return body
+
+    def _parse_binary(self, frame: bytes) -> dict[str, Any] | None:
+        """Parse a CRC-checked binary frame per PROTOCOL.md.
+
+        Telemetry payload: uint16 field mask, uint32 t_ms (v2 only), then
+        int16 per set bit (field order = TSV_FIELDS). Fields not in the mask
+        become NaN.
+        """
+        version, ftype, seq, length = frame[0], frame[1], frame[2], frame[3]
+        payload = frame[4:4 + length]
+        if version not in self.SUPPORTED_VERSIONS:
+            print(f"[Arduino] Unsupported protocol version {version}")
+            return None
+        header = 6 if version >= 2 else 2
+        if ftype != self.FRAME_TELEMETRY or length < header:
+            return None
+
+        mask = payload[0] | (payload[1] << 8)
+        present = [i for i in range(len(self.TSV_FIELDS)) if mask & (1 << i)]
+        if length != header + 2 * len(present):
+            return None
+        values = struct.unpack_from(f"<{len(present)}h", payload, header)
+
+        result = {name: float('nan') for name in self.TSV_FIELDS}
+        for i, raw in zip(present, values):
+            result[self.TSV_FIELDS[i]] = raw * self.BIN_SCALES[i]
+        result["seq"] = seq
+        if version >= 2:
+            (result["t_ms"],) = struct.unpack_from("<I", payload, 2)
+
+        return self._apply_mounting(result)
+
+    def _parse_range(self, frame: bytes) -> dict[str, Any] | None:
+        """Parse a range frame (type 0x04): min/max of each aggregated field
+        since it was last sent (CMD:AGG range=1).
+
+        Payload: uint16 field mask (V_bat and IMU bits only), then int16 min,
+        int16 max per set bit. Returned as "<field>_min" / "<field>_max".
+        """
+        version, length = frame[0], frame[3]
+        if version not in self.SUPPORTED_VERSIONS or length < 2:
+            return None
+        payload = frame[4:4 + length]
+        mask = payload[0] | (payload[1] << 8)
+        present = [i for i in range(len(self.TSV_FIELDS)) if mask & (1 << i)]
+        if length != 2 + 4 * len(present):
+            return None
+        values = struct.unpack_from(f"<{2 * len(present)}h", payload, 2)
+
+        result = {}
+        for n, i in enumerate(present):
+            name, scale = self.TSV_FIELDS[i], self.BIN_SCALES[i]
+            lo, hi = values[2 * n] * scale, values[2 * n + 1] * scale
+            if name in ('pitch', 'yaw'):
+                lo, hi = -hi, -lo  # Inverted by the mounting, as _apply_mounting()
+            result[f"{name}_min"] = lo
+            result[f"{name}_max"] = hi
+        return result
+
+    def _parse_imu_batch(self, frame: bytes) -> list[dict[str, Any]] | None:
+        """Parse an IMU batch frame (type 0x02) into timestamped samples.
+
+        Payload: uint8 count, uint32 t0 (micros of the first sample), then per
+        sample uint16 dt_us (since the previous one) + 9 int16 raw ax..yaw.
+        Returns None for any other frame type.
+        """
+        version, ftype, length = frame[0], frame[1], frame[3]
+        if version not in self.SUPPORTED_VERSIONS or ftype != self.FRAME_IMU_BATCH or length < 5:
+            return None
+        payload = frame[4:4 + length]
+        count = payload[0]
+        if length != 5 + count * 20:
+            return None
+
+        (t_us,) = struct.unpack_from("<I", payload, 1)
+        scales = self.BIN_SCALES[1:10]
+        samples = []
+        for n in range(count):
+            dt, *raw = struct.unpack_from("<H9h", payload, 5 + n * 20)
+            t_us = (t_us + dt) & 0xFFFFFFFF
+            sample = {name: v * k for name, v, k in zip(self.IMU_FIELDS, raw, scales)}
+            sample["t_us"] = t_us
+            samples.append(self._apply_mounting(sample))
+        return samples
+
+    def _parse_alert_frame(self, frame: bytes) -> dict[str, Any] | None:
+        """Parse an alert frame (type 0x03): uint8 rule, uint8 active,
+        int16 value (rule units), uint32 t_ms. None for any other frame type.
+        """
+        version, ftype, length = frame[0], frame[1], frame[3]
+        if version not in self.SUPPORTED_VERSIONS or ftype != self.FRAME_ALERT or length != 8:
+            return None
+        rule, active, value, t_ms = struct.unpack_from("<BBhI", frame, 4)
+        name = self.ALERT_RULES[rule] if rule < len(self.ALERT_RULES) else f"RULE{rule}"
+        return {"rule": name, "active": bool(active), "value": value, "t_ms": t_ms}
+
+    def _dispatch_alert(self, alert: dict[str, Any]):
+        """Hand an alert event straight to the callback - not merged into
+        telemetry, it is a state change, not a sample."""
+        state = "ON" if alert["active"] else "OFF"
+        print(f"[Arduino] ALERT {alert['rule']} {state} ({alert['value']})")
+        if self._on_alert_callback:
+            self._on_alert_callback(alert)
+
+    def _parse_perf(self, body: str) -> dict[str, Any]:
+        """Parse "key=value:key=value" perf counters into a dict."""
+        result = {}
+        for part in body.split(":"):
+            key, sep, val = part.partition("=")
+            if sep:
+                try:
+                    result[key] = int(val)
+                except ValueError:
+                    pass
+        result["time"] = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime())
+        return result
+
     def _parse_line(self, line: str) -> dict[str, Any] | None:
         """Parse a line from Arduino - TSV first, then JSON, fallback to regex.
 
@@ -277,16 +685,20 @@ class ArduinoService:
     def _parse_tsv(self, line: str) -> dict[str, Any] | None:
         """Parse TSV telemetry frame per PROTOCOL.md.
 
-        Fields: voltage, ax, ay, az, gx, gy, gz, roll, pitch, yaw
-        Empty fields (stale IMU) become NaN.
+        Fields: voltage, ax, ay, az, gx, gy, gz, roll, pitch, yaw, rpm, gear,
+        speed, eng_temp, imu_temp (newer firmware), then seq and t_ms (newer
+        firmware). Empty fields (stale IMU, no temperature sensor) become NaN,
+        as do fields older firmware doesn't send.
         """
         fields = line.split('\t')
-        if len(fields) != len(self.TSV_FIELDS):
+        count = self.TSV_LAYOUTS.get(len(fields))
+        if count is None:
             # Wrong field count - might be debug output or malformed
             return None
+        names = self.TSV_FIELDS[:count]
 
-        result = {}
-        for i, name in enumerate(self.TSV_FIELDS):
+        result = {name: float('nan') for name in self.TSV_FIELDS}
+        for i, name in enumerate(names):
             val_str = fields[i].strip()
             if val_str == '':
                 # Empty field = stale/missing data
@@ -297,8 +709,20 @@ class ArduinoService:
                 except ValueError:
                     result[name] = float('nan')
 
-        # IMU axis correction for mounting orientation
-        # Pitch/yaw inverted for motorcycle frame alignment (roll left as-is)
+        if len(fields) > len(names):
+            try:
+                result["seq"] = int(fields[-2])
+                result["t_ms"] = int(fields[-1])
+            except ValueError:
+                pass
+
+        return self._apply_mounting(result)
+
+    def _apply_mounting(self, result: dict[str, Any]) -> dict[str, Any]:
+        """IMU axis correction for mounting orientation.
+
+        Pitch/yaw inverted for motorcycle frame alignment (roll left as-is).
+        """
         if 'pitch' in result and not math.isnan(result['pitch']):
             result['pitch'] = -result['pitch']
         if 'yaw' in result and not math.isnan(result['yaw']):
@@ -147,6 +147,30 @@ def on_gps_data(data):
     gps_throttle.maybe_emit(data, emit_fn)
 
 
+# Firmware alert rules (PROTOCOL.md): UI text and value unit per rule
+ARDUINO_ALERTS = {
+    "VLOW": ("Battery low", "mV"),
+    "VHIGH": ("Battery overvoltage", "mV"),
+    "REV": ("Over-rev", "RPM"),
+    "LEAN": ("Lean angle", "°"),
+    "ACCEL": ("Acceleration spike", "mg"),
+}
+
+
+def on_arduino_alert(alert):
+    """Called by ArduinoService on a firmware alert - pushed straight out,
+    no throttling, so warnings reach the UI as soon as they are raised."""
+    text, unit = ARDUINO_ALERTS.get(alert["rule"], (alert["rule"], ""))
+    state = "" if alert["active"] else " cleared"
+    socketio.emit("alert", {
+        "type": f"arduino_{alert['rule'].lower()}",
+        "message": f"{text}{state}: {alert['value']}{unit}",
+        "active": alert["active"],
+        "value": alert["value"],
+        "t_ms": alert["t_ms"],
+    })
+
+
 def on_arduino_ack(cmd, status, extra):
     """Called by ArduinoService when ACK received from Arduino."""
     socketio.emit("ack", {
@@ -206,6 +230,16 @@ def arduino_data():
     return jsonify(arduino.get_latest())
 
 
+@app.route("/arduino/perf")
+def arduino_perf():
+    """Firmware loop timing and error counters (last report, asks for a fresh one).
+
+    "link" holds the Pi-side frame loss counters.
+    """
+    arduino.send_command("PERF")
+    return jsonify({**arduino.get_perf(), "link": arduino.get_link_stats()})
+
+
 @app.route("/arduino/history")
 def arduino_history():
     """Buffered Arduino telemetry history."""
@@ -221,6 +255,7 @@ def main():
     # Wire up callbacks
     arduino.set_on_data(on_arduino_data)
     arduino.set_on_ack(on_arduino_ack)
+    arduino.set_on_alert(on_arduino_alert)
     gps.set_on_data(on_gps_data)
 
     # Start services